@@ -0,0 +1,13 @@
+#pragma once
+#include <Arduino.h>
+
+//* ************************************************************************
+//* ******************************* BOOT *********************************
+//* ************************************************************************
+// This file contains the declarations for the boot timeline, a list of
+// timestamped startup phases from power-on to the first IDLE.
+
+void markBootPhase(const char* label);  // Label must be a string literal
+void completeBootTimeline();            // Marks "ready" and closes the timeline
+bool isBootComplete();
+void printBootTimeline();
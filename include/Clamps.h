@@ -0,0 +1,58 @@
+#pragma once
+#include <Arduino.h>
+#include "settings.h"
+#include "Timers.h"
+
+//* ************************************************************************
+//* ****************************** CLAMPS ********************************
+//* ************************************************************************
+// This file contains the declarations for the peak-and-hold clamp valve
+// driver. Engaging a valve drives it at full supply until it has pulled
+// in, then drops to its hold duty; the peak end and the feedback timeout are
+// SoftTimers, so nothing blocks. Where a sensor sees the clamp act, the time
+// from the output switching to its edge is recorded as that valve's actuation
+// latency; a valve set to gate on it also ends the peak on that edge.
+
+enum ClampPhase {
+  CLAMP_OFF,
+  CLAMP_PEAK,     // Full supply, pulling in
+  CLAMP_HOLD,     // Reduced duty, engaged
+  CLAMP_DUMP      // Released, dump pin pulsed
+};
+
+// Times from the output switching to the feedback sensor edge
+struct ClampLatency {
+  uint32_t count;
+  uint64_t totalUs;
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint32_t missed;          // No edge within CLAMP_FEEDBACK_TIMEOUT_MS
+};
+
+struct ClampDriver {
+  const char* name;
+  ClampDriveSettings settings;
+  uint8_t pin;
+  uint8_t channel;          // LEDC channel
+  uint8_t dumpPin;
+  uint8_t feedbackPin;
+  ClampPhase phase;
+  uint32_t holdDuty;        // From the overdrive ratio
+  SoftTimer phaseTimer;     // Ends the peak or the dump pulse
+  SoftTimer feedbackTimer;  // Gives up on a feedback edge
+  bool awaitingFeedback;
+  int feedbackLevel;        // Level that completes the pending measurement
+  uint32_t switchedAtUs;
+  ClampLatency engageLatency;
+  ClampLatency releaseLatency;
+};
+
+struct Station;
+
+void initializeClamps(Station& station);   // Sets up the LEDC channels; clamps start released
+void engageClamp(Station& station, ClampValve valve);
+void releaseClamp(Station& station, ClampValve valve);
+bool isClampEngaged(const Station& station, ClampValve valve);  // Gating sensor's edge seen, else peak over
+void serviceClamps();                      // Call from loop(): watches the feedback sensors
+void printClamps(Station& station);
+void resetClampLatencies(Station& station);
@@ -0,0 +1,10 @@
+#pragma once
+#include <Arduino.h>
+
+//* ************************************************************************
+//* ***************************** CONSOLE ********************************
+//* ************************************************************************
+// This file contains the declarations for the line-oriented serial command
+// console. Type 'help' over Serial for the command list.
+
+void serviceConsole(); // Call from loop(): consumes at most one byte per call
@@ -6,4 +6,7 @@
 //* ************************************************************************
 // This file contains the declarations for the cutting state functions. 
 
-void performCutCycle(); 
\ No newline at end of file
+struct Station;
+
+void performCutCycle(Station& station);   // Entry: engages the clamps; the cut stroke follows once they are in
+void runCuttingState(Station& station);   // Waits for the stroke, then checks for wood
\ No newline at end of file
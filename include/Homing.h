@@ -1,11 +1,43 @@
 #pragma once
 #include <Arduino.h>
+#include <FastAccelStepper.h>
+#include <Bounce2.h>
+#include "Trace.h"
+#include "Timers.h"
 
 //* ************************************************************************
 //* ****************************** HOMING ********************************
 //* ************************************************************************
-// This file contains the declarations for the homing state functions. 
+// This file contains the declarations for the homing state functions.
 
-void runHomingSequence();
-void homeCutMotor();
-void homePositionMotor();
\ No newline at end of file
+struct Station;
+
+enum HomingPhase {
+  HOMING_SEEK,      // Moving towards the home switch
+  HOMING_OFFSET,    // Backing off the switch before setting the final zero
+  HOMING_PARK,      // Moving to the park position after zeroing
+  HOMING_DONE,
+  HOMING_FAILED
+};
+
+// Progress of one axis through its homing sequence
+struct AxisHoming {
+  const char* name;
+  uint8_t stationId;
+  FastAccelStepper* stepper;
+  TraceAxis traceAxis;
+  Bounce homeSwitch;
+  HomingPhase phase;
+  SoftTimer timeout;    // Bounds the current phase
+  long offsetSteps;     // Distance from the switch to the final zero (0 = zero at the switch)
+  long parkSteps;       // Position to move to once zeroed (0 = stay at zero); runs under the feed profile
+};
+
+// Axis selection for Station::homingAxes
+const uint8_t HOME_CUT_AXIS = 0x01;
+const uint8_t HOME_POSITION_AXIS = 0x02;
+
+void enterHomingState(Station& station);   // Starts homing the requested axes in parallel
+void runHomingState(Station& station);     // Advances the axes; transitions to IDLE when done
+void homeCutMotor(Station& station);       // Re-homes one axis through the HOMING state
+void homePositionMotor(Station& station);
@@ -6,5 +6,7 @@
 //* ************************************************************************
 // This file contains the declarations for the IDLE state.
 
-void enterIdleState();
-void runIdleState(); 
\ No newline at end of file
+struct Station;
+
+void enterIdleState(Station& station);
+void runIdleState(Station& station); 
\ No newline at end of file
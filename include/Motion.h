@@ -0,0 +1,72 @@
+#pragma once
+#include <Arduino.h>
+#include "settings.h"
+#include "Trace.h"
+
+//* ************************************************************************
+//* ****************************** MOTION ********************************
+//* ************************************************************************
+// This file contains the declarations for profiled single-axis moves and
+// coordinated two-axis moves. Every move runs under a MotionProfile chosen by
+// its MoveKind, and its actual duration is recorded against that profile.
+// Coordinated moves give both axes speeds and accelerations that make them
+// start and finish together, so neither runs harder than the joint move requires.
+
+struct AxisMoveLimits {
+  float maxSpeed;           // steps/sec
+  float maxAcceleration;    // steps/sec²
+};
+
+struct CoordinatedMove {
+  bool achievable;          // false if the time budget is shorter than the limits allow
+  float durationSec;        // Planned time for both axes to arrive
+  float cutSpeed;
+  float cutAcceleration;
+  float positionSpeed;
+  float positionAcceleration;
+};
+
+// Plans a joint move over the given step distances. timeBudgetSec = 0 means
+// as fast as the limits allow; a longer budget slows both axes to fit it.
+CoordinatedMove planCoordinatedMove(long cutDistanceSteps, long positionDistanceSteps,
+                                    AxisMoveLimits cutLimits, AxisMoveLimits positionLimits,
+                                    float timeBudgetSec = 0);
+
+// Actual durations of the moves run under one profile on one axis
+struct ProfileDurations {
+  uint32_t count;
+  uint64_t totalUs;
+  uint32_t minUs;
+  uint32_t maxUs;
+};
+
+// The move an axis is running, timed until the stepper stops
+struct ActiveMove {
+  bool active;
+  MoveKind kind;
+  uint32_t startUs;
+  float plannedSec;         // Planned duration of the last move started, 0 if it had no distance
+};
+
+struct Station;
+
+// Apply kind's profile to one axis and start an absolute or relative move
+bool startProfileMove(Station& station, TraceAxis axis, MoveKind kind, long targetSteps);
+bool startProfileMoveBy(Station& station, TraceAxis axis, MoveKind kind, long steps);
+
+// Plans from the station's current positions and starts both axes if achievable.
+// The axis limits are the speeds and accelerations of kind's profile. The plan
+// is a trapezoid per axis, so the profile's jerk is not used: the S-curve is off.
+bool startCoordinatedMove(Station& station, long cutTargetSteps, long positionTargetSteps, MoveKind kind,
+                          float timeBudgetSec = 0, CoordinatedMove* planOut = NULL);
+
+bool isCoordinatedMoveKind(MoveKind kind);  // Runs through startCoordinatedMove(); its jerk must stay 0
+
+// Timeouts from the planned durations: MOVE_TIMEOUT_FACTOR times the plan plus MOVE_TIMEOUT_MARGIN_MS
+uint32_t moveTimeoutMs(float plannedSec);
+uint32_t moveTimeoutMs(const Station& station, TraceAxis axis);  // For the last move started on axis
+uint32_t moveTimeoutMs(const Station& station);                  // Longer of both axes
+
+void serviceMotionProfiles();     // Call from loop(): records the durations of finished moves
+MotionProfile* findMotionProfile(Station& station, const char* name);
+void printMotionProfiles(Station& station);  // Profile table with the recorded durations
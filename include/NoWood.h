@@ -6,5 +6,7 @@
 //* ************************************************************************
 // This file contains the declarations for the 'no wood' state functions. 
 
-void enterNoWoodState();
-void runNoWoodState(); 
\ No newline at end of file
+struct Station;
+
+void enterNoWoodState(Station& station);
+void runNoWoodState(Station& station); 
\ No newline at end of file
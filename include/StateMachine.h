@@ -13,7 +13,8 @@ typedef enum {
   CUTTING,
   YES_WOOD,
   NO_WOOD,
-  ERROR         // Added: Represents an error condition state
+  ERROR,        // Added: Represents an error condition state
+  BENCHMARK     // Step generation stress test, started from the console; re-homes when done
   // Add other states here
 } MachineState;
 
@@ -27,20 +28,9 @@ enum ErrorCode {
     // Add other specific error codes as needed
 };
 
-extern MachineState currentState;
-extern ErrorCode currentError; // Added: Global variable to store the current error code
+struct Station;
 
-void transitionToState(MachineState newState);
-void runStateMachine();
-void initializeStateMachine(); // To set the initial state if needed outside of homing sequence 
-
-// --- Utility Functions ---
-/**
- * @brief Non-blocking wait utility.
- * 
- * @param interval The duration to wait in milliseconds.
- * @param startTime Pointer to a variable holding the start time (millis()). 
- *                  This variable will be updated by the function on the first call for a new wait cycle.
- * @return true if the interval has passed, false otherwise.
- */
-bool Wait(unsigned long interval, unsigned long* startTime); 
\ No newline at end of file
+void transitionToState(Station& station, MachineState newState);
+void runStateMachine(Station& station);
+void initializeStateMachine(Station& station); // Sets the initial HOMING state and starts homing
+const char* stateToString(MachineState state);
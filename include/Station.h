@@ -0,0 +1,54 @@
+#pragma once
+#include <Arduino.h>
+#include <FastAccelStepper.h>
+#include <Bounce2.h>
+#include "settings.h"
+#include "StateMachine.h"
+#include "Homing.h"
+#include "Stats.h"
+#include "Timers.h"
+#include "Motion.h"
+#include "Clamps.h"
+
+//* ************************************************************************
+//* ***************************** STATION ********************************
+//* ************************************************************************
+// This file contains the declarations for a saw station: its I/O map, axis
+// handles, settings, state machine state, errors and statistics. loop() runs
+// every station's state machine once per pass, so no state may block.
+
+struct Station {
+  uint8_t id;
+  const StationPins* pins;
+  MotionProfile profiles[MOVE_KIND_COUNT];   // Live copy of DEFAULT_MOTION_PROFILES
+  FastAccelStepper* cutMotor;
+  FastAccelStepper* positionMotor;
+  uint8_t cutBackend;           // FastAccelStepper DRIVER_* actually in use
+  uint8_t positionBackend;
+
+  MachineState state;
+  ErrorCode error;
+  uint8_t step;                 // Progress through multi-step states (CUTTING, YES_WOOD)
+  SoftTimer stepTimer;          // Dwell or timeout of the current step, cancelled on each step change
+  uint8_t stepFlags;            // Progress bits within the current step, cleared on each step change
+
+  Bounce cycleSwitch;
+  uint8_t homingAxes;           // HOME_*_AXIS bits for the next HOMING entry (0 = full sequence)
+  AxisHoming cutHoming;
+  AxisHoming positionHoming;
+  bool homedOnce;
+  ClampDriver clamps[CLAMP_VALVE_COUNT];             // Indexed by ClampValve
+
+  StationStats stats;
+  ActiveMove activeMoves[2];                         // Indexed by TraceAxis
+  ProfileDurations moveDurations[MOVE_KIND_COUNT][2];
+};
+
+extern Station stations[STATION_COUNT];
+
+void initializeStations(FastAccelStepperEngine& engine); // Sets up I/O and connects the steppers
+void setStationStep(Station& station, uint8_t step);
+const char* stepBackendName(uint8_t backend);
+uint8_t countStepBackendAxes(uint8_t backend);   // Axes on that backend across all stations
+void faultStation(Station& station, ErrorCode error);   // Stops both axes and enters ERROR
+bool areAxesStopped(const Station& station);            // Neither stepper is running (e.g. after a jog)
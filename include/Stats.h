@@ -0,0 +1,53 @@
+#pragma once
+#include <Arduino.h>
+#include "StateMachine.h"
+#include "Timers.h"
+
+//* ************************************************************************
+//* ****************************** STATS *********************************
+//* ************************************************************************
+// This file contains the declarations for the shift-level throughput and
+// availability accounting. Counters are updated from transitionToState() and
+// persisted to NVS so that per-shift figures survive reboots.
+
+// Persisted shift counters (stored as a single NVS blob)
+struct ShiftStats {
+  uint32_t version;
+  uint32_t yesWoodCycles;
+  uint32_t noWoodCycles;
+  uint32_t errorCycles;
+  uint32_t homingCount;
+  uint32_t bootCount;
+  uint64_t idleMs;
+  uint64_t producingMs;
+  uint64_t homingMs;        // Total time spent homing
+  uint32_t lastHomingMs;    // Duration of the most recent homing sequence
+};
+
+const uint8_t STATS_WINDOW_MINUTES = 60;
+
+// Per-station accounting: persisted counters plus RAM-only bookkeeping
+struct StationStats {
+  ShiftStats shift;
+  bool dirty;
+  SoftTimer saveTimer;                          // Next NVS write: periodic, or batched after cycles
+  uint8_t saveDeferrals;                        // Retries of a due save while an axis was moving
+  unsigned long stateEnteredAt;                 // millis() when the current state was entered
+  uint16_t cycleBuckets[STATS_WINDOW_MINUTES + 1];  // Cycles per minute: the last hour plus the current minute
+  uint32_t bucketMinute;                        // Absolute minute index of the newest (current) bucket
+  uint32_t firstFullMinute;                     // First minute fully covered since boot or reset
+};
+
+struct Station;
+
+void initializeStats();   // Loads the counters of every station
+void recordStateTransition(Station& station, MachineState oldState, MachineState newState);
+void serviceStats();      // Call from loop(): keeps the rolling windows current
+void saveStats(Station& station);     // Force an NVS write of the current counters
+void resetStats(Station& station);    // Start a new shift: clears persisted counters and rolling windows
+void printStats(Station& station);
+
+// Cycles completed in the last windowMinutes (1..60) complete minutes. The
+// current, partial minute is not included. spanMinutes receives the minutes
+// actually covered, which is less than windowMinutes shortly after boot or reset.
+uint32_t getCyclesInWindow(Station& station, uint8_t windowMinutes, uint8_t* spanMinutes = NULL);
@@ -0,0 +1,16 @@
+#pragma once
+#include <Arduino.h>
+
+//* ************************************************************************
+//* *************************** STEP BENCHMARK ***************************
+//* ************************************************************************
+// This file contains the declarations for the step generation stress
+// benchmark. It runs as the BENCHMARK state of one station: both axes sweep
+// the speeds and accelerations in settings.h together while a CPU load task
+// and Serial output run, and every step pulse is counted back through a PCNT
+// loopback to flag missed pulses and late (slower than planned) moves.
+
+struct Station;
+
+void enterStepBenchmark(Station& station);  // Returns to IDLE at once if the loopback is unavailable
+void runStepBenchmark(Station& station);    // Advances the sweep; re-homes the station when done
@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+
+//* ************************************************************************
+//* ***************************** TIMERS *********************************
+//* ************************************************************************
+// This file contains the declarations for the software timer service. Every
+// dwell, timeout and deferred action is a SoftTimer: arm it, then either poll
+// its fired flag from a state's run function or give it a callback. Timers
+// are serviced from loop() before the state machines, never from an ISR.
+
+typedef void (*TimerCallback)(void* arg);
+
+struct SoftTimer {
+  SoftTimer* next;          // Wheel slot list links
+  SoftTimer* prev;
+  uint32_t deadline;        // millis() at which it is due
+  uint32_t armedAtUs;       // micros() when armed, for the lateness figure
+  uint32_t delayMs;
+  TimerCallback callback;   // Optional; runs from serviceTimers()
+  void* arg;
+  const char* name;         // Set by setupTimer(); must be a string literal
+  bool armed;
+  bool fired;               // Event flag: set on expiry, cleared by armTimer()/cancelTimer()
+  uint32_t firedCount;
+  uint32_t lastLatenessUs;
+  uint32_t maxLatenessUs;
+  uint32_t maxEarlyUs;      // Fired before its delay had passed; should stay 0
+};
+
+// Registers a timer so it shows up in printTimers(). Call once per timer.
+void setupTimer(SoftTimer& timer, const char* name, TimerCallback callback = NULL, void* arg = NULL);
+void armTimer(SoftTimer& timer, uint32_t delayMs);  // O(1); never fires early; re-arming restarts the delay
+void armTimerWithin(SoftTimer& timer, uint32_t delayMs);  // Like armTimer(), unless already due sooner
+void cancelTimer(SoftTimer& timer);                  // O(1); safe on a timer that is not armed
+bool timerFired(const SoftTimer& timer);
+
+void serviceTimers();         // Call from loop(): fires every timer that is due
+void printTimers();
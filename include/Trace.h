@@ -0,0 +1,46 @@
+#pragma once
+#include <Arduino.h>
+
+//* ************************************************************************
+//* ****************************** TRACE *********************************
+//* ************************************************************************
+// This file contains the declarations for the input/event trace capture.
+// Every input edge, motion command and state transition is stored in a
+// fixed RAM buffer with a microsecond timestamp and can be exported over
+// Serial for replay on the host (see tools/replay).
+
+enum TraceEventType : uint8_t {
+  TRACE_INPUT_LEVEL = 'L',      // Input level at capture start (id = pin)
+  TRACE_INPUT_EDGE = 'E',       // Input changed (id = pin, value = new level)
+  TRACE_MOVE_TO = 'M',          // Absolute move (id = axis, value = target steps)
+  TRACE_MOVE = 'R',             // Relative move (id = axis, value = steps)
+  TRACE_STOP = 'S',             // Stop or force stop (id = axis)
+  TRACE_SET_POSITION = 'P',     // Position overwritten (id = axis, value = new position)
+  TRACE_START_POSITION = 'A',   // Axis position at capture start (id = axis, value = steps)
+  TRACE_STATE = 'X'             // State entered (id = MachineState); also the state at capture start
+};
+
+enum TraceAxis : uint8_t {
+  TRACE_AXIS_CUT = 0,
+  TRACE_AXIS_POSITION = 1
+};
+
+struct TraceEvent {
+  uint32_t timeUs;      // micros() when the event was recorded
+  int32_t value;
+  uint8_t type;         // TraceEventType
+  uint8_t id;
+  uint8_t station;      // Station the event belongs to
+  uint8_t reserved;
+};
+
+void initializeTrace();         // Attaches the input edge interrupts of every station
+void startTraceCapture();       // Clears the buffer and starts recording
+void stopTraceCapture();
+void traceEvent(uint8_t station, TraceEventType type, uint8_t id, int32_t value);
+void dumpTrace();               // Starts exporting the buffer over Serial
+bool isTraceDumping();
+void serviceTrace();            // Call from loop(): sends the next lines of a dump in progress
+
+// Direct buffer access for the host replay harness
+const TraceEvent* getTraceEvents(size_t* count);
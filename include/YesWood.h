@@ -2,5 +2,5 @@
 
 #include "settings.h"
 
-void handleYesWoodState();
-void showYesWoodIndicator(); 
\ No newline at end of file
+void handleYesWoodState(Station& station);
+void showYesWoodIndicator(Station& station); 
\ No newline at end of file
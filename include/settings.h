@@ -7,9 +7,7 @@
 //* ************************************************************************
 // This file contains global settings, constants, and pin definitions for the project. 
 
-// Declare global FastAccelStepper pointers (to be defined in main.cpp)
-extern FastAccelStepper* cutMotorStepper;
-extern FastAccelStepper* positionMotorStepper;
+struct Station; // Defined in Station.h
 
 // Motor Constants
 const float CUT_MOTOR_STEPS_PER_INCH = 500;
@@ -31,8 +29,21 @@ const float POSITION_MOTOR_HOMING_SPEED = 1000;  // steps/sec
 const float CUT_MOTOR_HOMING_ACCELERATION = 2000; // steps/sec²
 const float POSITION_MOTOR_HOMING_ACCELERATION = 3000; // steps/sec²
 
+// Homing Sequence
+const float POSITION_MOTOR_HOMING_OFFSET = 1.0;  // inches from the home switch to the position axis zero
+const uint16_t HOMING_SWITCH_DEBOUNCE_MS = 2;
+const unsigned long HOMING_SEEK_TIMEOUT_MS = 15000;  // Max time to reach a home switch
+
 // Cutting State
 const float CUT_MOTOR_CUTTING_SPEED = 1000;  // steps/sec - slower speed for precise cutting
+const unsigned long WOOD_SENSOR_SETTLE_MS = 10;     // Dwell before the wood sensor is read
+
+// Move Timeouts
+// Every move of known length faults its station if it runs this much longer
+// than planned from its profile, so a profile slowed from the console still
+// gets a fitting timeout.
+const float MOVE_TIMEOUT_FACTOR = 1.5;
+const unsigned long MOVE_TIMEOUT_MARGIN_MS = 500;
 
 // Normal Operation / Return Speeds (can be categorized further if needed by other states)
 const float CUT_MOTOR_NORMAL_SPEED = 2000;  // steps/sec
@@ -40,10 +51,153 @@ const float CUT_MOTOR_RETURN_SPEED = 2000;  // steps/sec
 const float POSITION_MOTOR_NORMAL_SPEED = 2000;  // steps/sec
 const float POSITION_MOTOR_RETURN_SPEED = 2000;  // steps/sec
 
+// Jerk Limits (steps/sec³) for the S-curve start of each ramp; 0 = plain trapezoid.
+// The linear phase lasts N = a³ / (6 j²) steps. Each default is a² / v of its
+// profile, so the acceleration builds up until the axis reaches half its
+// speed, over a third of the ramp's steps (N = v² / (6 a)): 8 steps on the
+// stroke, 33 on a cut feed and 22 on a position feed or nudge. If you raise
+// an acceleration from the console, raise its jerk by the same factor to keep
+// that shape.
+const float CUT_MOTOR_STROKE_JERK = CUT_MOTOR_ACCELERATION * CUT_MOTOR_ACCELERATION / CUT_MOTOR_CUTTING_SPEED;
+const float CUT_MOTOR_FEED_JERK = CUT_MOTOR_ACCELERATION * CUT_MOTOR_ACCELERATION / CUT_MOTOR_NORMAL_SPEED;
+const float POSITION_MOTOR_FEED_JERK =
+    POSITION_MOTOR_ACCELERATION * POSITION_MOTOR_ACCELERATION / POSITION_MOTOR_NORMAL_SPEED;
+const float POSITION_MOTOR_NUDGE_JERK = POSITION_MOTOR_FEED_JERK;
+
+// --- Motion Profiles ---
+// One entry per kind of move; call sites choose a profile by its MoveKind.
+// Each station keeps a live copy that the serial console can tune under load,
+// and a change applies from the next move.
+enum MoveKind {
+  MOVE_HOMING_SEEK,   // Towards a home switch
+  MOVE_CUT_STROKE,    // The cut itself
+  MOVE_FEED,          // Full-length positioning, homing offset/park and jogs
+  MOVE_RETURN,        // Both axes back to zero together
+  MOVE_NUDGE,         // Short position corrections
+  MOVE_KIND_COUNT
+};
+
+struct AxisProfile {
+  float speed;         // steps/sec
+  float acceleration;  // steps/sec²
+  float jerk;          // steps/sec³, 0 = no S-curve
+};
+
+struct MotionProfile {
+  const char* name;    // Used by the console
+  AxisProfile cut;
+  AxisProfile position;
+};
+
+const MotionProfile DEFAULT_MOTION_PROFILES[MOVE_KIND_COUNT] = {
+  {"seek",
+   {CUT_MOTOR_HOMING_SPEED, CUT_MOTOR_HOMING_ACCELERATION, 0},
+   {POSITION_MOTOR_HOMING_SPEED, POSITION_MOTOR_HOMING_ACCELERATION, 0}},
+  {"stroke",  // Cut axis only
+   {CUT_MOTOR_CUTTING_SPEED, CUT_MOTOR_ACCELERATION, CUT_MOTOR_STROKE_JERK},
+   {POSITION_MOTOR_NORMAL_SPEED, POSITION_MOTOR_ACCELERATION, 0}},
+  {"feed",
+   {CUT_MOTOR_NORMAL_SPEED, CUT_MOTOR_ACCELERATION, CUT_MOTOR_FEED_JERK},
+   {POSITION_MOTOR_NORMAL_SPEED, POSITION_MOTOR_ACCELERATION, POSITION_MOTOR_FEED_JERK}},
+  {"return",  // Coordinated; the planner assumes a trapezoid, so the jerk must stay 0
+   {CUT_MOTOR_RETURN_SPEED, CUT_MOTOR_ACCELERATION, 0},
+   {POSITION_MOTOR_RETURN_SPEED, POSITION_MOTOR_ACCELERATION, 0}},
+  {"nudge",
+   {CUT_MOTOR_NORMAL_SPEED, CUT_MOTOR_ACCELERATION, CUT_MOTOR_FEED_JERK},
+   {POSITION_MOTOR_NORMAL_SPEED, POSITION_MOTOR_ACCELERATION, POSITION_MOTOR_NUDGE_JERK}}
+};
+
 // Operational Constants
 const float WAS_WOOD_SUCTIONED_POSITION = 0.3;  // inches
 const float TRANSFER_ARM_SIGNAL_POSITION = 7.2;  // inches 
 
+// Step Generation
+// FastAccelStepper backend for each axis on the ESP32-S3: DRIVER_MCPWM_PCNT
+// (MCPWM timer with a PCNT step counter) or DRIVER_RMT (RMT channel). Each
+// has 4 channels. If the chosen one is used up the axis falls back to the
+// other. Override with -D build flags to compare them.
+#ifndef CUT_MOTOR_STEP_BACKEND
+#define CUT_MOTOR_STEP_BACKEND DRIVER_MCPWM_PCNT
+#endif
+#ifndef POSITION_MOTOR_STEP_BACKEND
+#define POSITION_MOTOR_STEP_BACKEND DRIVER_MCPWM_PCNT
+#endif
+
+// Step Benchmark ('bench' console command)
+// Jumper each step pin of the station under test to its loopback pin; the
+// pulses are counted there by a spare PCNT unit. Run with the blade off.
+// Neither may be a strapping pin (0, 3, 45, 46): a jumper to a step output
+// would set the boot mode.
+#define STEP_LOOPBACK_CUT_PIN 42
+#define STEP_LOOPBACK_POSITION_PIN 41
+const uint32_t STEP_BENCH_SPEEDS[] = {2000, 5000, 10000, 20000, 40000};      // steps/sec
+const uint32_t STEP_BENCH_ACCELERATIONS[] = {20000, 50000, 100000, 200000}; // steps/sec²
+const uint8_t STEP_BENCH_REPEATS = 3;               // Out-and-back moves per point
+const float STEP_BENCH_LATE_TOLERANCE = 0.03;       // Allowed move time overrun over the ideal profile
+const unsigned long STEP_BENCH_LATE_SLACK_US = 2000; // Plus this, for loop polling granularity
+const unsigned long STEP_BENCH_SERIAL_LOAD_MS = 10; // Status line interval while a point runs
+
+// Statistics
+const unsigned long STATS_SAVE_INTERVAL_MS = 600000;      // Periodic save of the time counters
+const unsigned long STATS_CYCLE_SAVE_DELAY_MS = 120000;   // Save within this of a cycle ending; bounds the NVS write rate
+const unsigned long STATS_SAVE_RETRY_MS = 250;            // Retry a save that is due while an axis moves
+const uint8_t STATS_SAVE_MAX_DEFERRALS = 40;              // Then save anyway, 10 s late at most
+
+// Clamp Valve Drive
+// Each valve is driven from its own LEDC channel: a full-supply peak pulse
+// pulls it in, then a lower hold duty keeps it in with less heat. A feedback
+// sensor is timed on every switch; only a valve with gateOnFeedback waits for
+// its edge (which also ends the peak early), the others count as engaged
+// after peakMs. On release an optional dump pin (the reverse leg of an
+// H-bridge, or the switch of a zener dump path) is pulsed to collapse the
+// coil field quickly.
+//
+// Overdrive is opt-in. It needs a valve supply above the coil rating (e.g. a
+// 24 V rail into 12 V coils), a driver and flyback path rated for that
+// supply, and a peakMs the coil tolerates at that voltage. Only then set
+// overdriveRatio to supply / rating: the peak then pulls in faster, and the
+// hold duty scales down to keep the same hold current.
+#define CLAMP_NO_PIN 0xFF                        // No dump or feedback pin on this valve
+const uint32_t CLAMP_PWM_FREQUENCY_HZ = 20000;   // Above audible range
+const uint8_t CLAMP_PWM_RESOLUTION_BITS = 10;
+const int CLAMP_FEEDBACK_ENGAGED_LEVEL = LOW;    // Feedback sensors are active LOW like the wood sensor
+const unsigned long CLAMP_FEEDBACK_TIMEOUT_MS = 500;  // Stop waiting for a feedback edge after this
+const uint32_t CLAMP_FEEDBACK_WARN_EVERY = 10;   // Warn on the first missed edge and every this many after
+
+enum ClampValve {
+  CLAMP_POSITION,
+  CLAMP_SECURE_WOOD,
+  CLAMP_VALVE_COUNT
+};
+
+struct ClampDriveSettings {
+  float overdriveRatio; // Valve supply voltage / coil rated voltage; 1 = no overdrive
+  uint16_t peakMs;      // Longest full-supply pull-in; keep it short when overdriving
+  float holdFraction;   // Hold current as a fraction of the rated current; duty = holdFraction / overdriveRatio
+  uint16_t dumpMs;      // Dump pin pulse on release, 0 = none
+  bool gateOnFeedback;  // Engaged on the sensor edge; only for a sensor confirmed to see this clamp
+};
+
+// Defaults for coils rated at the supply voltage, as the plain HIGH drive
+// assumed: no overdrive, and a hold well above the usual drop-out current.
+// Lower holdFraction only after checking on the machine that the clamps hold.
+// Neither valve gates on feedback: the secure clamp's sensor on station 0 is
+// the wood-suctioned sensor, which is not known to see the clamp itself.
+const ClampDriveSettings CLAMP_DRIVE_SETTINGS[CLAMP_VALVE_COUNT] = {
+  {1.0, 30, 0.7, 0, false},  // Position clamp
+  {1.0, 30, 0.7, 0, false}   // Secure wood clamp
+};
+
+// Software Timers
+const uint16_t TIMER_WHEEL_SLOTS = 256;  // One slot per millisecond; must be a power of two
+const uint8_t MAX_TIMERS = 20;           // Timers listed by the console (8 per station, plus the bench)
+
+// Trace Capture
+#ifndef TRACE_BUFFER_EVENTS
+#define TRACE_BUFFER_EVENTS 2048  // 12 bytes per event; overridable for host replay builds
+#endif
+const bool TRACE_CAPTURE_AT_BOOT = true;  // Start recording in setup() so homing is captured
+
 // Motor Pin Definitions
 #define CUT_MOTOR_PULSE_PIN 12
 #define CUT_MOTOR_DIR_PIN 11
@@ -74,19 +228,58 @@ const float TRANSFER_ARM_SIGNAL_POSITION = 7.2;  // inches
 #define GREEN_LED_PIN 47
 #define BLUE_LED_PIN 21 
 
+// --- Stations ---
+// One controller can run several saw stations from the same stepper engine.
+// Each station has its own I/O map; station 0 uses the pin definitions above.
+struct StationPins {
+  uint8_t cutMotorPulse;
+  uint8_t cutMotorDir;
+  uint8_t positionMotorPulse;
+  uint8_t positionMotorDir;
+  uint8_t cutMotorHomingSwitch;
+  uint8_t positionMotorHomingSwitch;
+  uint8_t cycleSwitch;
+  uint8_t woodSensor;
+  uint8_t positionClamp;
+  uint8_t secureWoodClamp;
+  uint8_t positionClampDump;       // CLAMP_NO_PIN if not fitted
+  uint8_t secureWoodClampDump;
+  uint8_t positionClampFeedback;   // Sensor that sees the clamp engage, CLAMP_NO_PIN if none
+  uint8_t secureWoodClampFeedback; // The wood-suctioned sensor on station 0, timed only
+};
+
+const uint8_t STATION_COUNT = 1;  // Raise once the next station in STATION_PIN_MAPS is wired
+const uint8_t MAX_STATIONS = 2;
+
+const StationPins STATION_PIN_MAPS[MAX_STATIONS] = {
+  { // Station 0
+    CUT_MOTOR_PULSE_PIN, CUT_MOTOR_DIR_PIN, POSITION_MOTOR_PULSE_PIN, POSITION_MOTOR_DIR_PIN,
+    CUT_MOTOR_HOMING_SWITCH_PIN, POSITION_MOTOR_HOMING_SWITCH_PIN, CYCLE_SWITCH_PIN,
+    YES_OR_NO_WOOD_SENSOR_PIN,
+    POSITION_CLAMP_PIN, SECURE_WOOD_CLAMP_PIN,
+    CLAMP_NO_PIN, CLAMP_NO_PIN,
+    CLAMP_NO_PIN, WAS_WOOD_SUCTIONED_SENSOR_PIN
+  },
+  { // Station 1 (free ESP32-S3 GPIOs, no strapping or USB pins)
+    13, 14, 15, 7,
+    4, 8, 9,
+    1,
+    39, 40,
+    CLAMP_NO_PIN, CLAMP_NO_PIN,
+    CLAMP_NO_PIN, 38
+  }
+};
+static_assert(STATION_COUNT <= MAX_STATIONS, "STATION_PIN_MAPS has no entry for every station");
+
 // --- Motor Control Function Declarations ---
-void configureCutMotorForReturn();
-void configurePositionMotorForReturn();
-void configureCutMotorForNormalOperation();
-void configurePositionMotorForNormalOperation();
-void moveCutMotorToPositionInches(float positionInches);
-void movePositionMotorToPositionInches(float positionInches);
-bool isCutMotorAtTarget(); 
-bool isPositionMotorAtTarget();
+void moveCutMotorToPositionInches(Station& station, float positionInches, MoveKind kind);
+void movePositionMotorToPositionInches(Station& station, float positionInches, MoveKind kind);
+bool isCutMotorAtTarget(Station& station);
+bool isPositionMotorAtTarget(Station& station);
 
 // --- Switch and Sensor Function Declarations ---
-bool isCutMotorAtHome();
-bool readPositionMotorHomingSwitch();
+bool isCutMotorAtHome(Station& station);
+bool readPositionMotorHomingSwitch(Station& station);
 
 // --- LED Control Function Declarations ---
 void setYellowLed(bool state);
@@ -95,7 +288,7 @@ void setBlueLed(bool state);
 void setRedLed(bool state); 
 
 // --- Clamp Control Function Declarations ---
-void extendSecureWoodClamp();
-void retractSecureWoodClamp();
-void extendPositionClamp();
-void retractPositionClamp(); 
\ No newline at end of file
+void extendSecureWoodClamp(Station& station);
+void retractSecureWoodClamp(Station& station);
+void extendPositionClamp(Station& station);
+void retractPositionClamp(Station& station); 
\ No newline at end of file
@@ -2,73 +2,63 @@
 #include "settings.h"
 #include "StateMachine.h"
 #include <FastAccelStepper.h>
-#include "Homing.h"
+#include "Station.h"
+#include "Stats.h"
+#include "Trace.h"
+#include "Console.h"
+#include "Boot.h"
+#include "Timers.h"
+#include "Motion.h"
+#include "Clamps.h"
 
 //* ************************************************************************
 //* ****************************** MAIN **********************************
 //* ************************************************************************
 // This file contains the main setup and loop functions for the automated table saw.
 
-// Define FastAccelStepper engine and stepper objects
+// One FastAccelStepper engine drives the axes of every station
 FastAccelStepperEngine engine = FastAccelStepperEngine();
-FastAccelStepper* cutMotorStepper = NULL;
-FastAccelStepper* positionMotorStepper = NULL;
 
 void setup() {
-  Serial.begin(115200); // Initialize Serial for debugging
-  delay(500); // Short delay to ensure serial port initializes
-  
-  Serial.println("=== System Startup ===");
-  Serial.println("Initializing pins and stepper motors...");
-
-  // Initialize Clamp Pins
-  pinMode(POSITION_CLAMP_PIN, OUTPUT);
-  pinMode(SECURE_WOOD_CLAMP_PIN, OUTPUT);
-  digitalWrite(POSITION_CLAMP_PIN, LOW); // Start with clamps disengaged
-  digitalWrite(SECURE_WOOD_CLAMP_PIN, LOW); // Start with clamps disengaged
-
-  // Initialize Wood Sensor Pin
-  pinMode(YES_OR_NO_WOOD_SENSOR_PIN, INPUT_PULLDOWN);
-
-  Serial.println("Initializing FastAccelStepper engine...");
-  engine.init();
+  // No wait for the USB host: output sent before it connects is simply dropped
+  Serial.begin(115200);
+  markBootPhase("serial");
 
-  Serial.println("Connecting Cut Motor Stepper...");
-  cutMotorStepper = engine.stepperConnectToPin(CUT_MOTOR_PULSE_PIN);
-  if (cutMotorStepper) {
-    cutMotorStepper->setDirectionPin(CUT_MOTOR_DIR_PIN);
-    Serial.println("Cut Motor Stepper connected successfully");
-    // cutMotorStepper->setEnablePin(CUT_MOTOR_ENABLE_PIN); // Enable pin not used as per settings
-    // cutMotorStepper->setAutoEnable(true); // Decide if you want auto-enable
-    // cutMotorStepper->setDirectionPinHighIsForward(true); // Set based on your wiring
-  } else {
-    Serial.println("ERROR: Failed to connect Cut Motor Stepper!");
+  engine.init();
+  initializeStations(engine); // I/O and steppers for every station in one pass
+  markBootPhase("io and steppers");
+
+  initializeTrace(); // After the input pins, so the trace starts from their real levels
+  initializeStats();
+  markBootPhase("trace and stats");
+
+  Serial.print("=== System Startup: "); Serial.print(STATION_COUNT); Serial.println(" station(s) ===");
+  for (Station& station : stations) {
+    if (!station.cutMotor) { Serial.print("ERROR: Failed to connect Cut Motor Stepper of station "); Serial.println(station.id); }
+    if (!station.positionMotor) { Serial.print("ERROR: Failed to connect Position Motor Stepper of station "); Serial.println(station.id); }
+    Serial.print("Station "); Serial.print(station.id);
+    Serial.print(" step backends: cut "); Serial.print(stepBackendName(station.cutBackend));
+    Serial.print(", position "); Serial.println(stepBackendName(station.positionBackend));
   }
 
-  Serial.println("Connecting Position Motor Stepper...");
-  positionMotorStepper = engine.stepperConnectToPin(POSITION_MOTOR_PULSE_PIN);
-  if (positionMotorStepper) {
-    positionMotorStepper->setDirectionPin(POSITION_MOTOR_DIR_PIN);
-    Serial.println("Position Motor Stepper connected successfully");
-    // positionMotorStepper->setEnablePin(POSITION_MOTOR_ENABLE_PIN); // Enable pin not used
-    // positionMotorStepper->setAutoEnable(true);
-    // positionMotorStepper->setDirectionPinHighIsForward(true); // Set based on your wiring
-  } else {
-    Serial.println("ERROR: Failed to connect Position Motor Stepper!");
+  // Homing runs from loop() as the HOMING state, all axes in parallel
+  for (Station& station : stations) {
+    initializeStateMachine(station);
   }
-  
-  Serial.println("Initializing State Machine...");
-  initializeStateMachine(); // Initialize the state machine
-
-  Serial.println("Homing sequence starting...");
-  runHomingSequence(); // This will now transition to IDLE state internally
-  Serial.println("Homing sequence completed and system should be in IDLE state.");
-
-  // Other setup code here
+  markBootPhase("homing started");
 }
 
 void loop() {
-  runStateMachine();
+  serviceTimers(); // Fired timers are seen by the state machines in this same pass
+
+  // Round-robin: every station gets one non-blocking state machine pass
+  for (Station& station : stations) {
+    runStateMachine(station);
+  }
+  serviceClamps();
+  serviceMotionProfiles();
+  serviceStats();
+  serviceConsole();
 }
 
 // --- LED Control Function Stubs ---
@@ -89,75 +79,51 @@ void setRedLed(bool state) {
   // digitalWrite(RED_LED_PIN, state ? HIGH : LOW);
 }
 
-// --- Motor Configuration Function Stubs ---
-void configureCutMotorForReturn() {
-  Serial.println("STUB: configureCutMotorForReturn called");
-  // if (cutMotorStepper) { cutMotorStepper->setSpeedInHz(CUT_MOTOR_RETURN_SPEED); cutMotorStepper->setAcceleration(CUT_MOTOR_ACCELERATION); }
-}
-void configurePositionMotorForReturn() {
-  Serial.println("STUB: configurePositionMotorForReturn called");
-  // if (positionMotorStepper) { positionMotorStepper->setSpeedInHz(POSITION_MOTOR_RETURN_SPEED); positionMotorStepper->setAcceleration(POSITION_MOTOR_ACCELERATION); }
-}
-void configureCutMotorForNormalOperation() {
-  Serial.println("STUB: configureCutMotorForNormalOperation called");
-  // if (cutMotorStepper) { cutMotorStepper->setSpeedInHz(CUT_MOTOR_NORMAL_SPEED); cutMotorStepper->setAcceleration(CUT_MOTOR_ACCELERATION); }
-}
-void configurePositionMotorForNormalOperation() {
-  Serial.println("STUB: configurePositionMotorForNormalOperation called");
-  // if (positionMotorStepper) { positionMotorStepper->setSpeedInHz(POSITION_MOTOR_NORMAL_SPEED); positionMotorStepper->setAcceleration(POSITION_MOTOR_ACCELERATION); }
-}
-
-// --- Motor Movement Function Stubs ---
-void moveCutMotorToPositionInches(float positionInches) {
-  Serial.print("STUB: moveCutMotorToPositionInches called with inches: "); Serial.println(positionInches);
-  // if (cutMotorStepper) { cutMotorStepper->moveTo(positionInches * CUT_MOTOR_STEPS_PER_INCH); }
+// --- Motor Movement Functions ---
+// These start real profiled moves. YES_WOOD steps 2 and 7 rely on them to
+// take the position axis back out to its travel after the coordinated
+// return, which is where homing parks it for the next cut.
+void moveCutMotorToPositionInches(Station& station, float positionInches, MoveKind kind) {
+  startProfileMove(station, TRACE_AXIS_CUT, kind, (long)(positionInches * CUT_MOTOR_STEPS_PER_INCH));
 }
-void movePositionMotorToPositionInches(float positionInches) {
-  Serial.print("STUB: movePositionMotorToPositionInches called with inches: "); Serial.println(positionInches);
-  // if (positionMotorStepper) { positionMotorStepper->moveTo(positionInches * POSITION_MOTOR_STEPS_PER_INCH); }
+void movePositionMotorToPositionInches(Station& station, float positionInches, MoveKind kind) {
+  startProfileMove(station, TRACE_AXIS_POSITION, kind, (long)(positionInches * POSITION_MOTOR_STEPS_PER_INCH));
 }
 
-// --- Motor Status Function Stubs ---
-bool isCutMotorAtTarget() { 
-  Serial.println("STUB: isCutMotorAtTarget called, returning true");
-  // return cutMotorStepper ? !cutMotorStepper->isRunning() : true; // Simplified stub
-  return true; // Placeholder
+// --- Motor Status Functions ---
+bool isCutMotorAtTarget(Station& station) {
+  return station.cutMotor ? !station.cutMotor->isRunning() : true;
 }
-bool isPositionMotorAtTarget() { 
-  Serial.println("STUB: isPositionMotorAtTarget called, returning true");
-  // return positionMotorStepper ? !positionMotorStepper->isRunning() : true; // Simplified stub
-  return true; // Placeholder
+bool isPositionMotorAtTarget(Station& station) {
+  return station.positionMotor ? !station.positionMotor->isRunning() : true;
 }
 
-// --- Switch and Sensor Function Stubs ---
-bool isCutMotorAtHome() {
-  Serial.println("STUB: isCutMotorAtHome called, returning true");
-  // return digitalRead(CUT_MOTOR_HOMING_SWITCH_PIN) == LOW; // Example, assuming active LOW
-  return true; // Placeholder
+// --- Switch and Sensor Functions ---
+// Home switches read HIGH when active (INPUT_PULLDOWN), as in the homing sequence
+bool isCutMotorAtHome(Station& station) {
+  return digitalRead(station.pins->cutMotorHomingSwitch) == HIGH;
 }
-bool readPositionMotorHomingSwitch() {
-  Serial.println("STUB: readPositionMotorHomingSwitch called, returning true");
-  // return digitalRead(POSITION_MOTOR_HOMING_SWITCH_PIN) == LOW; // Example, assuming active LOW
-  return true; // Placeholder
+bool readPositionMotorHomingSwitch(Station& station) {
+  return digitalRead(station.pins->positionMotorHomingSwitch) == HIGH;
 }
 
 // --- Clamp Control Function Definitions ---
-void extendSecureWoodClamp() {
-    digitalWrite(SECURE_WOOD_CLAMP_PIN, HIGH);
+void extendSecureWoodClamp(Station& station) {
+    engageClamp(station, CLAMP_SECURE_WOOD);
     Serial.println("Secure wood clamp extended.");
 }
 
-void retractSecureWoodClamp() {
-    digitalWrite(SECURE_WOOD_CLAMP_PIN, LOW);
+void retractSecureWoodClamp(Station& station) {
+    releaseClamp(station, CLAMP_SECURE_WOOD);
     Serial.println("Secure wood clamp retracted.");
 }
 
-void extendPositionClamp() {
-    digitalWrite(POSITION_CLAMP_PIN, HIGH);
+void extendPositionClamp(Station& station) {
+    engageClamp(station, CLAMP_POSITION);
     Serial.println("Position clamp extended.");
 }
 
-void retractPositionClamp() {
-    digitalWrite(POSITION_CLAMP_PIN, LOW);
+void retractPositionClamp(Station& station) {
+    releaseClamp(station, CLAMP_POSITION);
     Serial.println("Position clamp retracted.");
 } 
\ No newline at end of file
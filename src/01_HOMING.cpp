@@ -1,5 +1,9 @@
 #include "Homing.h"
 #include "settings.h"
+#include "Trace.h"
+#include "Boot.h"
+#include "Station.h"
+#include "Motion.h"
 #include <FastAccelStepper.h>
 #include <Bounce2.h>
 #include "StateMachine.h" // For transitioning to IDLE state
@@ -8,211 +12,175 @@
 //* ************************************************************************
 //* ****************************** HOMING ********************************
 //* ************************************************************************
-// This file contains the definitions for the homing state functions. 
-
-void runHomingSequence() {
-  Serial.println("==== HOMING SEQUENCE STARTED ====");
-  
-  //! Setup Homing Switches with Bounce2
-  Bounce cutMotorSwitch = Bounce();
-  Bounce positionMotorSwitch = Bounce();
-
-  Serial.println("Setting up homing switches...");
-  
-  // Initialize the homing switches
-  pinMode(CUT_MOTOR_HOMING_SWITCH_PIN, INPUT_PULLDOWN);
-  pinMode(POSITION_MOTOR_HOMING_SWITCH_PIN, INPUT_PULLDOWN);
-  
-  Serial.print("CUT_MOTOR_HOMING_SWITCH_PIN ("); 
-  Serial.print(CUT_MOTOR_HOMING_SWITCH_PIN);
-  Serial.print(") initial state: ");
-  Serial.println(digitalRead(CUT_MOTOR_HOMING_SWITCH_PIN) ? "HIGH" : "LOW");
-  
-  Serial.print("POSITION_MOTOR_HOMING_SWITCH_PIN (");
-  Serial.print(POSITION_MOTOR_HOMING_SWITCH_PIN);
-  Serial.print(") initial state: ");
-  Serial.println(digitalRead(POSITION_MOTOR_HOMING_SWITCH_PIN) ? "HIGH" : "LOW");
-
-  cutMotorSwitch.attach(CUT_MOTOR_HOMING_SWITCH_PIN, INPUT_PULLDOWN);
-  positionMotorSwitch.attach(POSITION_MOTOR_HOMING_SWITCH_PIN, INPUT_PULLDOWN);
-
-  cutMotorSwitch.interval(2); // 2 ms debounce interval
-  positionMotorSwitch.interval(2); // 2 ms debounce interval
-
-  // Force an initial update of switch states
-  cutMotorSwitch.update();
-  positionMotorSwitch.update();
-  
-  Serial.print("Cut Motor Switch initial state: ");
-  Serial.println(cutMotorSwitch.read() ? "HIGH" : "LOW");
-  Serial.print("Position Motor Switch initial state: ");
-  Serial.println(positionMotorSwitch.read() ? "HIGH" : "LOW");
-
-  bool cutMotorHomed = false;
-  bool positionMotorHomed = false;
-
-  Serial.println("Starting cut motor homing...");
-  if (cutMotorStepper) {
-    cutMotorStepper->setSpeedInHz(CUT_MOTOR_HOMING_SPEED);
-    cutMotorStepper->setAcceleration(CUT_MOTOR_HOMING_ACCELERATION); 
-    cutMotorStepper->move(-2000000000); 
-    Serial.println("Cut motor moving to find home position");
-  } else {
-    Serial.println("ERROR: Cut motor stepper not initialized!");
-    cutMotorHomed = true; 
-  }
+// This file contains the definitions for the homing state functions.
+// Each axis runs its own small sequence (seek switch -> offset -> park) that
+// is advanced from runHomingState(), so both axes home fully in parallel and
+// the state machine keeps running while they do. Switch pins are configured
+// once in setup().
+
+// Arms the phase timeout; phases without one leave it cancelled
+static void setHomingPhase(AxisHoming& axis, HomingPhase phase, uint32_t timeoutMs = 0) {
+  axis.phase = phase;
+  if (timeoutMs) armTimer(axis.timeout, timeoutMs);
+  else cancelTimer(axis.timeout);
+}
 
-  Serial.println("Starting position motor homing...");
-  if (positionMotorStepper) {
-    positionMotorStepper->setSpeedInHz(POSITION_MOTOR_HOMING_SPEED);
-    positionMotorStepper->setAcceleration(POSITION_MOTOR_HOMING_ACCELERATION); 
-    positionMotorStepper->move(-2000000000); 
-    Serial.println("Position motor moving to find home position");
-  } else {
-    Serial.println("ERROR: Position motor stepper not initialized!");
-    positionMotorHomed = true; 
+static void failAxisHoming(AxisHoming& axis, const char* reason) {
+  axis.stepper->forceStop();
+  traceEvent(axis.stationId, TRACE_STOP, axis.traceAxis, 0);
+  Serial.print("ERROR: [S"); Serial.print(axis.stationId); Serial.print("] ");
+  Serial.print(axis.name); Serial.print(" motor homing failed: ");
+  Serial.println(reason);
+  setHomingPhase(axis, HOMING_FAILED);
+}
+
+static void startAxisHoming(Station& station, AxisHoming& axis, const char* name, FastAccelStepper* stepper,
+                            TraceAxis traceAxis, uint8_t switchPin) {
+  axis.name = name;
+  axis.stationId = station.id;
+  axis.stepper = stepper;
+  axis.traceAxis = traceAxis;
+  axis.offsetSteps = 0;
+  axis.parkSteps = 0;
+
+  if (!stepper) {
+    Serial.print("ERROR: "); Serial.print(name); Serial.println(" motor stepper not initialized!");
+    setHomingPhase(axis, HOMING_DONE); // Nothing to home
+    return;
   }
 
-  Serial.println("Waiting for homing switches to activate...");
-  unsigned long homingStartTime = millis();
-
-  while (!cutMotorHomed || !positionMotorHomed) {
-    cutMotorSwitch.update();
-    positionMotorSwitch.update();
-
-    if (!cutMotorHomed && cutMotorStepper && cutMotorSwitch.read() == HIGH) {
-      Serial.println("Cut motor home switch ACTIVATED.");
-      cutMotorStepper->forceStopAndNewPosition(0);
-      cutMotorHomed = true;
-      Serial.println("Cut motor homed successfully.");
-    }
-
-    if (!positionMotorHomed && positionMotorStepper && positionMotorSwitch.read() == HIGH) {
-      Serial.println("Position motor home switch ACTIVATED.");
-      positionMotorStepper->forceStopAndNewPosition(0); // Temporary zero at switch
-      
-      long oneInchSteps = (long)(1.0 * POSITION_MOTOR_STEPS_PER_INCH);
-      Serial.print("Position motor moving 1 inch away from switch to relative: "); Serial.println(oneInchSteps);
-      
-      // Use a standard speed for this short move, ensure it's defined
-      positionMotorStepper->setSpeedInHz(POSITION_MOTOR_NORMAL_SPEED); 
-      positionMotorStepper->setAcceleration(POSITION_MOTOR_ACCELERATION); // Use normal acceleration for the 1-inch move
-      positionMotorStepper->moveTo(oneInchSteps); // Move 1 inch from temporary zero
-      
-      unsigned long motorMoveStartTime = millis();
-      while (positionMotorStepper->isRunning()) {
-        delay(0); // Yield for other tasks, though this is blocking for homing
+  axis.homeSwitch.attach(switchPin); // Pin mode is set up in setup()
+  axis.homeSwitch.interval(HOMING_SWITCH_DEBOUNCE_MS);
+
+  startProfileMoveBy(station, traceAxis, MOVE_HOMING_SEEK, -2000000000); // Move towards switch
+  setHomingPhase(axis, HOMING_SEEK, HOMING_SEEK_TIMEOUT_MS);
+}
+
+// Advances one axis by at most one phase; never blocks
+static void runAxisHoming(Station& station, AxisHoming& axis) {
+  FastAccelStepper* stepper = axis.stepper;
+  bool timedOut = timerFired(axis.timeout);
+
+  switch (axis.phase) {
+    case HOMING_SEEK:
+      axis.homeSwitch.update();
+      if (axis.homeSwitch.read() == HIGH) {
+        stepper->forceStopAndNewPosition(0); // Zero at the switch
+        traceEvent(axis.stationId, TRACE_SET_POSITION, axis.traceAxis, 0);
+        if (axis.offsetSteps != 0) {
+          startProfileMove(station, axis.traceAxis, MOVE_FEED, axis.offsetSteps);
+          setHomingPhase(axis, HOMING_OFFSET, moveTimeoutMs(station, axis.traceAxis));
+        } else {
+          setHomingPhase(axis, HOMING_DONE);
+        }
+      } else if (timedOut) {
+        failAxisHoming(axis, "switch not triggered");
+      }
+      break;
+
+    case HOMING_OFFSET:
+      if (!stepper->isRunning()) {
+        stepper->setCurrentPosition(0); // New zero is offset from the switch
+        traceEvent(axis.stationId, TRACE_SET_POSITION, axis.traceAxis, 0);
+        if (axis.parkSteps != 0) {
+          startProfileMove(station, axis.traceAxis, MOVE_FEED, axis.parkSteps);
+          setHomingPhase(axis, HOMING_PARK, moveTimeoutMs(station, axis.traceAxis));
+        } else {
+          setHomingPhase(axis, HOMING_DONE);
+        }
+      } else if (timedOut) {
+        failAxisHoming(axis, "timeout during offset move");
       }
-      
-      positionMotorStepper->setCurrentPosition(0); // New zero is 1 inch away from the switch
-      positionMotorHomed = true;
-      Serial.println("Position motor homed and offset by 1 inch. New zero set.");
-
-      positionMotorStepper->moveTo(3.45); // Move 3.45 inches from home switch
-      while (positionMotorStepper->isRunning()) {
-                delay(0); // Yield for other tasks, though this is blocking for homing
+      break;
+
+    case HOMING_PARK:
+      if (!stepper->isRunning()) {
+        setHomingPhase(axis, HOMING_DONE);
+      } else if (timedOut) {
+        failAxisHoming(axis, "timeout during park move");
       }
-      Serial.println("Position motor moved to 3.45 inches from home switch.");
-    }
-    
-    delay(0); 
+      break;
+
+    default:
+      break;
   }
+}
 
-  Serial.println("==== HOMING SEQUENCE COMPLETED ====");
-  Serial.println("Transitioning to IDLE state");
-  transitionToState(IDLE);
-} 
+static void startCutAxisHoming(Station& station) {
+  startAxisHoming(station, station.cutHoming, "Cut", station.cutMotor, TRACE_AXIS_CUT,
+                  station.pins->cutMotorHomingSwitch);
+}
 
-//* ************************************************************************
-//* *********************** INDIVIDUAL HOMING ****************************
-//* ************************************************************************
-// These functions home individual motors without changing the machine state.
+static void startPositionAxisHoming(Station& station, bool park) {
+  AxisHoming& axis = station.positionHoming;
+  startAxisHoming(station, axis, "Position", station.positionMotor, TRACE_AXIS_POSITION,
+                  station.pins->positionMotorHomingSwitch);
+  axis.offsetSteps = (long)(POSITION_MOTOR_HOMING_OFFSET * POSITION_MOTOR_STEPS_PER_INCH);
+  axis.parkSteps = park ? (long)(POSITION_MOTOR_TRAVEL_DISTANCE * POSITION_MOTOR_STEPS_PER_INCH) : 0;
+}
 
-void homeCutMotor() {
-  if (!cutMotorStepper) {
-    Serial.println("ERROR: homeCutMotor - Cut motor stepper not initialized!");
-    return;
-  }
+void enterHomingState(Station& station) {
+  // A full sequence homes both axes and parks the position axis; a single-axis
+  // request (from homeCutMotor()/homePositionMotor()) leaves the other axis alone
+  uint8_t axes = station.homingAxes ? station.homingAxes : (HOME_CUT_AXIS | HOME_POSITION_AXIS);
+  bool fullSequence = station.homingAxes == 0;
+  station.homingAxes = 0;
+
+  Serial.print("HOMING [S"); Serial.print(station.id); Serial.println("]: Homing axes.");
+  if (axes & HOME_CUT_AXIS) startCutAxisHoming(station);
+  else setHomingPhase(station.cutHoming, HOMING_DONE);
+  if (axes & HOME_POSITION_AXIS) startPositionAxisHoming(station, fullSequence);
+  else setHomingPhase(station.positionHoming, HOMING_DONE);
+}
 
-  Serial.println("INFO: Homing Cut Motor...");
-  pinMode(CUT_MOTOR_HOMING_SWITCH_PIN, INPUT_PULLDOWN); // Ensure pinMode is set
-  Bounce cutMotorSwitch = Bounce();
-  cutMotorSwitch.attach(CUT_MOTOR_HOMING_SWITCH_PIN, INPUT_PULLDOWN);
-  cutMotorSwitch.interval(5); // Debounce interval
-
-  cutMotorStepper->setSpeedInHz(CUT_MOTOR_HOMING_SPEED);
-  cutMotorStepper->setAcceleration(CUT_MOTOR_HOMING_ACCELERATION);
-  cutMotorStepper->move(-2000000000); // Move towards switch
-
-  unsigned long startTime = millis();
-  bool homed = false;
-  while (!homed && millis() - startTime < 15000) { // 15-second timeout
-    cutMotorSwitch.update();
-    if (cutMotorSwitch.read() == HIGH) {
-      cutMotorStepper->forceStopAndNewPosition(0);
-      homed = true;
-      Serial.println("INFO: Cut motor homed successfully.");
-    }
-    delay(1); // Small delay to prevent busy-waiting
+// Boot is complete once every station has homed for the first time
+static bool allStationsHomed() {
+  for (Station& other : stations) {
+    if (!other.homedOnce) return false;
   }
+  return true;
+}
 
-  if (!homed) {
-    Serial.println("ERROR: Cut motor homing timeout or switch not triggered.");
-    cutMotorStepper->forceStop(); // Stop motor if timeout
-    // Optionally, set an error state or flag here
+void runHomingState(Station& station) {
+  AxisHoming& cutAxis = station.cutHoming;
+  AxisHoming& positionAxis = station.positionHoming;
+  bool cutWasDone = cutAxis.phase == HOMING_DONE;
+  bool positionWasDone = positionAxis.phase == HOMING_DONE;
+
+  runAxisHoming(station, cutAxis);
+  runAxisHoming(station, positionAxis);
+
+  if (!cutWasDone && cutAxis.phase == HOMING_DONE) markBootPhase("cut axis homed");
+  if (!positionWasDone && positionAxis.phase == HOMING_DONE) markBootPhase("position axis homed");
+
+  if (cutAxis.phase == HOMING_FAILED || positionAxis.phase == HOMING_FAILED) {
+    // Stop the other axis too so nothing keeps moving in the ERROR state
+    if (cutAxis.phase != HOMING_FAILED && station.cutMotor) station.cutMotor->forceStop();
+    if (positionAxis.phase != HOMING_FAILED && station.positionMotor) station.positionMotor->forceStop();
+    station.error = (cutAxis.phase == HOMING_FAILED) ? CUT_MOTOR_HOME_ERROR_EC : POSITION_MOTOR_HOME_ERROR_EC;
+    transitionToState(station, ERROR);
+  } else if (cutAxis.phase == HOMING_DONE && positionAxis.phase == HOMING_DONE) {
+    Serial.print("HOMING [S"); Serial.print(station.id); Serial.println("]: Homing complete.");
+    station.homedOnce = true;
+    if (!isBootComplete() && allStationsHomed()) completeBootTimeline();
+    transitionToState(station, IDLE);
   }
 }
 
-void homePositionMotor() {
-  if (!positionMotorStepper) {
-    Serial.println("ERROR: homePositionMotor - Position motor stepper not initialized!");
-    return;
-  }
+//* ************************************************************************
+//* *********************** INDIVIDUAL HOMING ****************************
+//* ************************************************************************
+// These functions re-home a single motor. They run through the HOMING state
+// so the other stations keep running, and return the station to IDLE.
 
-  Serial.println("INFO: Homing Position Motor...");
-  pinMode(POSITION_MOTOR_HOMING_SWITCH_PIN, INPUT_PULLDOWN); // Ensure pinMode is set
-  Bounce positionMotorSwitch = Bounce();
-  positionMotorSwitch.attach(POSITION_MOTOR_HOMING_SWITCH_PIN, INPUT_PULLDOWN);
-  positionMotorSwitch.interval(5); // Debounce interval
-
-  positionMotorStepper->setSpeedInHz(POSITION_MOTOR_HOMING_SPEED);
-  positionMotorStepper->setAcceleration(POSITION_MOTOR_HOMING_ACCELERATION);
-  positionMotorStepper->move(-2000000000); // Move towards switch
-
-  unsigned long startTime = millis();
-  bool switchedTriggered = false;
-  while (!switchedTriggered && millis() - startTime < 15000) { // 15-second timeout
-    positionMotorSwitch.update();
-    if (positionMotorSwitch.read() == HIGH) {
-      positionMotorStepper->forceStopAndNewPosition(0); // Temporarily set zero at switch
-      switchedTriggered = true;
-      Serial.println("INFO: Position motor switch triggered.");
-
-      // Move 1 inch away from the switch
-      long oneInchSteps = (long)(1.0 * POSITION_MOTOR_STEPS_PER_INCH);
-      Serial.print("INFO: Position motor moving 1 inch away from switch to relative: "); Serial.println(oneInchSteps);
-      
-      positionMotorStepper->setSpeedInHz(POSITION_MOTOR_NORMAL_SPEED); 
-      positionMotorStepper->setAcceleration(POSITION_MOTOR_ACCELERATION);
-      positionMotorStepper->moveTo(oneInchSteps);
-      
-      unsigned long motorMoveStartTime = millis();
-      while (positionMotorStepper->isRunning() && millis() - motorMoveStartTime < 5000) { // 5 sec timeout for 1-inch move
-        delay(1); 
-      }
-      if (!positionMotorStepper->isRunning()){
-        positionMotorStepper->setCurrentPosition(0); // New zero is 1 inch away
-        Serial.println("INFO: Position motor homed and offset by 1 inch. New zero set.");
-      } else {
-        positionMotorStepper->forceStop();
-        Serial.println("ERROR: Position motor timeout during 1-inch offset move.");
-      }
-    }
-    delay(1); // Small delay
-  }
+void homeCutMotor(Station& station) {
+  Serial.println("INFO: Homing Cut Motor...");
+  station.homingAxes = HOME_CUT_AXIS;
+  transitionToState(station, HOMING);
+}
 
-  if (!switchedTriggered) {
-    Serial.println("ERROR: Position motor homing timeout or switch not triggered.");
-    positionMotorStepper->forceStop(); // Stop motor if timeout
-  }
-} 
\ No newline at end of file
+void homePositionMotor(Station& station) {
+  Serial.println("INFO: Homing Position Motor...");
+  station.homingAxes = HOME_POSITION_AXIS;
+  transitionToState(station, HOMING);
+}
@@ -1,64 +1,90 @@
 #include "Cutting.h"
 #include "settings.h"
+#include "Trace.h"
+#include "Station.h"
+#include "Timers.h"
+#include "Motion.h"
+#include "Clamps.h"
 #include <FastAccelStepper.h>
 #include "StateMachine.h" // For state transitions
 
 //* ************************************************************************
 //* ***************************** CUTTING ********************************
 //* ************************************************************************
-// This file contains the definitions for the cutting state functions. 
+// This file contains the definitions for the cutting state functions.
+// The cut runs as a few steps advanced from runCuttingState(), so other
+// stations keep running while the stroke is in progress.
 
-void performCutCycle() {
-  Serial.println("CUTTING: Engaging clamps...");
-  digitalWrite(POSITION_CLAMP_PIN, HIGH);
-  digitalWrite(SECURE_WOOD_CLAMP_PIN, HIGH);
+enum CuttingStep {
+  CUTTING_CLAMP,        // Waiting for both clamps to engage
+  CUTTING_STROKE,       // Waiting for the cut motor to finish its travel
+  CUTTING_SENSOR_SETTLE // Short settle before the wood sensor is read
+};
+
+static void startSensorSettle(Station& station) {
+  setStationStep(station, CUTTING_SENSOR_SETTLE);
+  armTimer(station.stepTimer, WOOD_SENSOR_SETTLE_MS);
+}
 
-  // Short delay to ensure clamps are engaged before movement
-  // This is a blocking delay, consider if a non-blocking alternative is needed for complex state management
+void performCutCycle(Station& station) {
+  Serial.println("CUTTING: Engaging clamps...");
+  extendPositionClamp(station);
+  extendSecureWoodClamp(station);
+  setStationStep(station, CUTTING_CLAMP); // The stroke starts once both valves have pulled in
+}
 
+static void startCutStroke(Station& station) {
   Serial.println("CUTTING: Moving cut motor for cutting operation...");
-  if (cutMotorStepper) {
+  FastAccelStepper* cutMotor = station.cutMotor;
+  if (cutMotor) {
     long targetPositionSteps = (long)(CUT_MOTOR_TRAVEL_DISTANCE * CUT_MOTOR_STEPS_PER_INCH);
-    
-    cutMotorStepper->setSpeedInHz(CUT_MOTOR_CUTTING_SPEED);
-    cutMotorStepper->setAcceleration(CUT_MOTOR_ACCELERATION);
-    
+
     // Assuming the motor is at its home/start position (0) before cutting
     // And CUT_MOTOR_TRAVEL_DISTANCE is the distance to move *to* for the cut
-    cutMotorStepper->moveTo(targetPositionSteps);
-    
-    unsigned long motorMoveStartTime = millis();
-    while (cutMotorStepper->isRunning()) {
-      // Yield or add a small delay if other tasks need to run, though this sequence is mostly blocking
-      delay(0);
-      if (millis() - motorMoveStartTime > 15000) { // 15-second timeout for cut travel
-            Serial.println("ERROR: Timeout waiting for cut motor to complete travel!");
-            cutMotorStepper->stopMove(); 
-            break; 
-        }
-    }
-    Serial.println("CUTTING: Cut motor movement complete.");
-    
-    // After the cut, the next step would typically be to return the cut motor.
-    // This will be handled by subsequent instructions or states.
-
+    startProfileMove(station, TRACE_AXIS_CUT, MOVE_CUT_STROKE, targetPositionSteps);
+    setStationStep(station, CUTTING_STROKE);
+    armTimer(station.stepTimer, moveTimeoutMs(station, TRACE_AXIS_CUT));
   } else {
     Serial.println("ERROR: Cut motor stepper not initialized!");
+    startSensorSettle(station);
   }
-  
-  // After cutting operation, check for wood presence
-  // Sensor is active LOW (LOW means wood, HIGH means no wood)
-  // pinMode(YES_OR_NO_WOOD_SENSOR_PIN, INPUT_PULLDOWN); // Ensure pin is configured, could be done once in setup()
-  delay(10); // Small delay for sensor reading to stabilize if needed
-  int woodSensorState = digitalRead(YES_OR_NO_WOOD_SENSOR_PIN);
+}
+
+void runCuttingState(Station& station) {
+  switch (station.step) {
+    case CUTTING_CLAMP:
+      if (isClampEngaged(station, CLAMP_POSITION) && isClampEngaged(station, CLAMP_SECURE_WOOD)) {
+        startCutStroke(station);
+      }
+      break;
+
+    case CUTTING_STROKE:
+      if (!station.cutMotor->isRunning()) {
+        Serial.println("CUTTING: Cut motor movement complete.");
+        startSensorSettle(station);
+      } else if (timerFired(station.stepTimer)) {
+        Serial.println("ERROR: Timeout waiting for cut motor to complete travel!");
+        station.cutMotor->stopMove();
+        traceEvent(station.id, TRACE_STOP, TRACE_AXIS_CUT, 0);
+        startSensorSettle(station);
+      }
+      break;
 
-  Serial.print("CUTTING: Wood sensor state: ");
-  Serial.println(woodSensorState == LOW ? "WOOD PRESENT (LOW)" : "NO WOOD (HIGH)");
+    case CUTTING_SENSOR_SETTLE:
+      if (timerFired(station.stepTimer)) {
+        // After cutting operation, check for wood presence
+        // Sensor is active LOW (LOW means wood, HIGH means no wood)
+        int woodSensorState = digitalRead(station.pins->woodSensor);
 
-  if (woodSensorState == LOW) { // Wood is present
-    transitionToState(YES_WOOD);
-  } else { // No wood is present
-    transitionToState(NO_WOOD);
+        Serial.print("CUTTING: Wood sensor state: ");
+        Serial.println(woodSensorState == LOW ? "WOOD PRESENT (LOW)" : "NO WOOD (HIGH)");
+
+        if (woodSensorState == LOW) { // Wood is present
+          transitionToState(station, YES_WOOD);
+        } else { // No wood is present
+          transitionToState(station, NO_WOOD);
+        }
+      }
+      break;
   }
-  // Serial.println("CUTTING: Cut cycle part 1 (engage clamps and cut) finished."); // This message is now misleading
-} 
\ No newline at end of file
+}
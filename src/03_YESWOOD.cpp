@@ -1,5 +1,10 @@
 #include "YesWood.h"
 #include "settings.h" 
+#include "Motion.h"
+#include "Station.h"
+#include "Timers.h"
+#include "Clamps.h"
+#include "StateMachine.h" // For transitioning to IDLE state
 #include <Arduino.h> 
 
 //* ************************************************************************
@@ -7,93 +12,129 @@
 //* ************************************************************************
 // This file contains the logic for the "Yes Wood" operational state.
 // It handles the sequence of actions when wood is detected and the cycle is initiated.
+// Each call of handleYesWoodState() advances the sequence by at most one step
+// (tracked in station.step), so it never waits on a motor. Every move is
+// bounded by a timeout from its planned duration (moveTimeoutMs()) on the
+// station's step timer.
 
-// Assumed clamp control functions (defined in 00_MAIN.cpp)
-extern void extendSecureWoodClamp();
-extern void retractSecureWoodClamp();
-extern void extendPositionClamp();
-extern void retractPositionClamp();
+enum YesWoodStep {
+    YES_WOOD_START,             // Steps 1-2: release the secure clamp, advance the position motor
+    YES_WOOD_ADVANCE,           // Waiting for the position motor (step 2)
+    YES_WOOD_SWAP,              // Step 3: waiting for the secure wood clamp to pull in
+    YES_WOOD_RETURN,            // Steps 5-6: waiting for both motors to get home
+    YES_WOOD_REPOSITION         // Step 7: waiting for the position motor to reach travel distance
+};
 
-void showYesWoodIndicator() {
+// stepFlags bits during YES_WOOD_RETURN
+static const uint8_t YES_WOOD_POSITION_HOME = 0x01;
+static const uint8_t YES_WOOD_CUT_HOME = 0x02;
+
+void showYesWoodIndicator(Station& station) {
     // TODO: Implement what showing the YesWood indicator means, e.g., turn on a specific LED.
-    Serial.println("YesWood State: Indicator activated.");
+    Serial.print("YesWood State [S"); Serial.print(station.id); Serial.println("]: Indicator activated.");
     // Example: setGreenLed(true); 
 }
 
-void handleYesWoodState() {
-    //! 1. Retract the secure wood clamp
-    Serial.println("YesWood State: Retracting secure wood clamp.");
-    retractSecureWoodClamp();
-
-    //! 2. Move the position motor to POSITION_MOTOR_TRAVEL_DISTANCE - 0.1
-    float targetPositionStep2 = POSITION_MOTOR_TRAVEL_DISTANCE - 0.1;
-    Serial.print("YesWood State: Moving position motor to ");
-    Serial.print(targetPositionStep2);
-    Serial.println(" inches.");
-    configurePositionMotorForNormalOperation(); 
-    movePositionMotorToPositionInches(targetPositionStep2);
-    while (!isPositionMotorAtTarget()) {
-        delay(10); 
+// Step 4: start both motors home together
+static void startReturnHome(Station& station) {
+    //! 4. Both motors should now return to the zero position together
+    Serial.println("YesWood State: Returning both motors to home.");
+    CoordinatedMove returnMove;
+    if (startCoordinatedMove(station, 0, 0, MOVE_RETURN, 0, &returnMove)) {
+        Serial.print("YesWood State: Both motors arrive home in ");
+        Serial.print(returnMove.durationSec * 1000.0f, 0);
+        Serial.println(" ms.");
     }
-    Serial.println("YesWood State: Position motor reached target for step 2.");
+}
 
-    //! 3. Retract the position clamp and extend the secure wood clamp
-    Serial.println("YesWood State: Retracting position clamp and extending secure wood clamp.");
-    retractPositionClamp();
-    extendSecureWoodClamp();
+void handleYesWoodState(Station& station) {
+    switch (station.step) {
+        case YES_WOOD_START: {
+            //! 1. Retract the secure wood clamp
+            Serial.println("YesWood State: Retracting secure wood clamp.");
+            retractSecureWoodClamp(station);
 
-    //! 4. Both motors should now return to the zero position together
-    Serial.println("YesWood State: Returning both motors to home.");
-    configureCutMotorForReturn();
-    configurePositionMotorForReturn();
-    moveCutMotorToPositionInches(0);
-    movePositionMotorToPositionInches(0);
+            //! 2. Move the position motor to POSITION_MOTOR_TRAVEL_DISTANCE - 0.1
+            float targetPositionStep2 = POSITION_MOTOR_TRAVEL_DISTANCE - 0.1;
+            Serial.print("YesWood State: Moving position motor to ");
+            Serial.print(targetPositionStep2);
+            Serial.println(" inches.");
+            movePositionMotorToPositionInches(station, targetPositionStep2, MOVE_NUDGE);
+            setStationStep(station, YES_WOOD_ADVANCE);
+            armTimer(station.stepTimer, moveTimeoutMs(station, TRACE_AXIS_POSITION));
+            break;
+        }
 
-    bool cutMotorHome = false;
-    bool positionMotorHome = false;
+        case YES_WOOD_ADVANCE:
+            if (isPositionMotorAtTarget(station)) {
+                Serial.println("YesWood State: Position motor reached target for step 2.");
+
+                //! 3. Retract the position clamp and extend the secure wood clamp
+                Serial.println("YesWood State: Retracting position clamp and extending secure wood clamp.");
+                retractPositionClamp(station);
+                extendSecureWoodClamp(station);
+                setStationStep(station, YES_WOOD_SWAP);
+            } else if (timerFired(station.stepTimer)) {
+                Serial.println("ERROR: Timeout waiting for position motor in YES_WOOD.");
+                faultStation(station, POSITION_MOTOR_TIMEOUT_EC);
+            }
+            break;
 
-    // Non-blocking wait for both motors to reach home
-    // Also handles extending position clamp and retracting secure wood clamp at the right times
-    unsigned long motorCheckStartTime = millis();
-    while (!cutMotorHome || !positionMotorHome) {
-        if (!positionMotorHome && isPositionMotorAtTarget()) {
-            if (positionMotorStepper->getCurrentPosition() == 0) { // Double check it's actually at zero
+        case YES_WOOD_SWAP:
+            // The wood must be held before the motors move
+            if (isClampEngaged(station, CLAMP_SECURE_WOOD)) {
+                startReturnHome(station);
+                setStationStep(station, YES_WOOD_RETURN);
+                armTimer(station.stepTimer, moveTimeoutMs(station));
+            }
+            break;
+
+        case YES_WOOD_RETURN: {
+            // Clamps are switched as each motor arrives; stepFlags records which have
+            FastAccelStepper* cutMotor = station.cutMotor;
+            FastAccelStepper* positionMotor = station.positionMotor;
+            bool positionMotorHome = isPositionMotorAtTarget(station) && positionMotor->getCurrentPosition() == 0;
+            bool cutMotorHome = isCutMotorAtTarget(station) && cutMotor->getCurrentPosition() == 0;
+
+            if (positionMotorHome && !(station.stepFlags & YES_WOOD_POSITION_HOME)) {
                 //! 5. As soon as the position motor reaches position zero the position clamp should extend.
                 Serial.println("YesWood State: Position motor reached home. Extending position clamp.");
-                extendPositionClamp();
-                positionMotorHome = true;
+                extendPositionClamp(station);
+                station.stepFlags |= YES_WOOD_POSITION_HOME;
             }
-        }
-        if (!cutMotorHome && isCutMotorAtTarget()) {
-             if (cutMotorStepper->getCurrentPosition() == 0) { // Double check it's actually at zero
+            if (cutMotorHome && !(station.stepFlags & YES_WOOD_CUT_HOME)) {
                 //! 6. When the cut motor reaches home, the secure wood clamp should retract
                 Serial.println("YesWood State: Cut motor reached home. Retracting secure wood clamp.");
-                retractSecureWoodClamp();
-                cutMotorHome = true;
+                retractSecureWoodClamp(station);
+                station.stepFlags |= YES_WOOD_CUT_HOME;
             }
+
+            if ((station.stepFlags & YES_WOOD_POSITION_HOME) && (station.stepFlags & YES_WOOD_CUT_HOME)) {
+                Serial.println("YesWood State: Both motors reached home.");
+
+                //! 7. The position motor moves to position POSITION_MOTOR_TRAVEL_DISTANCE
+                Serial.print("YesWood State: Moving position motor to ");
+                Serial.print(POSITION_MOTOR_TRAVEL_DISTANCE);
+                Serial.println(" inches.");
+                movePositionMotorToPositionInches(station, POSITION_MOTOR_TRAVEL_DISTANCE, MOVE_FEED);
+                setStationStep(station, YES_WOOD_REPOSITION);
+                armTimer(station.stepTimer, moveTimeoutMs(station, TRACE_AXIS_POSITION));
+            } else if (timerFired(station.stepTimer)) {
+                Serial.println("ERROR: Timeout waiting for motors to home in YES_WOOD.");
+                faultStation(station, (station.stepFlags & YES_WOOD_CUT_HOME) ? POSITION_MOTOR_TIMEOUT_EC
+                                                                               : CUT_MOTOR_TIMEOUT_EC);
+            }
+            break;
         }
-        
-        // Optional: Add a timeout for motor homing if necessary, to prevent infinite loop
-        // if (millis() - motorCheckStartTime > MAX_HOMING_TIMEOUT) { 
-        //     Serial.println("Error: Timeout waiting for motors to home in YesWoodState.");
-        //     // Handle error, e.g., transition to an error state
-        //     break; 
-        // }
-        delay(10); // Small delay to yield to other processes and check motor status
-    }
-    Serial.println("YesWood State: Both motors reached home.");
 
-    //! 7. The position motor moves to position POSITION_MOTOR_TRAVEL_DISTANCE
-    Serial.print("YesWood State: Moving position motor to ");
-    Serial.print(POSITION_MOTOR_TRAVEL_DISTANCE);
-    Serial.println(" inches.");
-    configurePositionMotorForNormalOperation();
-    movePositionMotorToPositionInches(POSITION_MOTOR_TRAVEL_DISTANCE);
-    while (!isPositionMotorAtTarget()) {
-        delay(10); 
+        case YES_WOOD_REPOSITION:
+            if (isPositionMotorAtTarget(station)) {
+                Serial.println("YesWood State: Position motor reached final target. State complete.");
+                transitionToState(station, IDLE);
+            } else if (timerFired(station.stepTimer)) {
+                Serial.println("ERROR: Timeout waiting for position motor in YES_WOOD.");
+                faultStation(station, POSITION_MOTOR_TIMEOUT_EC);
+            }
+            break;
     }
-    Serial.println("YesWood State: Position motor reached final target. State complete.");
-    
-    // After completing the YesWood sequence, you might want to transition to another state, e.g., IDLE
-    // transitionToState(IDLE); // This would require transitionToState to be accessible here
 }
@@ -1,5 +1,8 @@
 #include "NoWood.h"
 #include "settings.h"
+#include "Motion.h"
+#include "Station.h"
+#include "Timers.h"
 #include <Arduino.h> // For Serial
 #include <FastAccelStepper.h>
 #include "StateMachine.h" // For state transitions
@@ -9,31 +12,24 @@
 //* ************************************************************************
 // This file contains the definitions for the 'no wood' state functions. 
 
-void enterNoWoodState() {
+void enterNoWoodState(Station& station) {
   Serial.println("ENTERING NO_WOOD STATE");
-  Serial.println("NO_WOOD: Returning Cut Motor to home...");
-  if (cutMotorStepper) {
-    cutMotorStepper->setSpeedInHz(CUT_MOTOR_RETURN_SPEED);
-    cutMotorStepper->setAcceleration(CUT_MOTOR_ACCELERATION);
-    cutMotorStepper->moveTo(0);
-  }
-  Serial.println("NO_WOOD: Returning Position Motor to home...");
-  if (positionMotorStepper) {
-    positionMotorStepper->setSpeedInHz(POSITION_MOTOR_RETURN_SPEED);
-    positionMotorStepper->setAcceleration(POSITION_MOTOR_ACCELERATION);
-    positionMotorStepper->moveTo(0);
-  }
+  Serial.println("NO_WOOD: Returning both motors to home together...");
+  startCoordinatedMove(station, 0, 0, MOVE_RETURN);
+  armTimer(station.stepTimer, moveTimeoutMs(station));
 }
 
-void runNoWoodState() {
-  bool cutMotorAtHome = (cutMotorStepper) ? !cutMotorStepper->isRunning() && cutMotorStepper->getCurrentPosition() == 0 : true;
-  bool positionMotorAtHome = (positionMotorStepper) ? !positionMotorStepper->isRunning() && positionMotorStepper->getCurrentPosition() == 0 : true;
+void runNoWoodState(Station& station) {
+  FastAccelStepper* cutMotor = station.cutMotor;
+  FastAccelStepper* positionMotor = station.positionMotor;
+  bool cutMotorAtHome = (cutMotor) ? !cutMotor->isRunning() && cutMotor->getCurrentPosition() == 0 : true;
+  bool positionMotorAtHome = (positionMotor) ? !positionMotor->isRunning() && positionMotor->getCurrentPosition() == 0 : true;
 
   if (cutMotorAtHome && positionMotorAtHome) {
-    if ((!cutMotorStepper || cutMotorStepper->getCurrentPosition() == 0) && 
-        (!positionMotorStepper || positionMotorStepper->getCurrentPosition() == 0)) {
-      Serial.println("NO_WOOD: Both motors returned home. Transitioning to IDLE.");
-      transitionToState(IDLE);
-    }
+    Serial.println("NO_WOOD: Both motors returned home. Transitioning to IDLE.");
+    transitionToState(station, IDLE);
+  } else if (timerFired(station.stepTimer)) {
+    Serial.println("ERROR: Timeout waiting for motors to return home in NO_WOOD.");
+    faultStation(station, cutMotorAtHome ? POSITION_MOTOR_TIMEOUT_EC : CUT_MOTOR_TIMEOUT_EC);
   }
-} 
\ No newline at end of file
+}
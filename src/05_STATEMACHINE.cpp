@@ -5,6 +5,10 @@
 #include "YesWood.h"
 #include "NoWood.h"
 #include "Idle.h"
+#include "Stats.h"
+#include "Trace.h"
+#include "Station.h"
+#include "StepBench.h"
 #include <Arduino.h>
 
 //* ************************************************************************
@@ -12,9 +16,6 @@
 //* ************************************************************************
 // This file contains the definitions for the state machine. 
 
-MachineState currentState;
-ErrorCode currentError = NO_ERROR_EC; // Definition for the global error code
-
 // Helper function to convert MachineState enum to string for printing
 const char* stateToString(MachineState state) {
   switch (state) {
@@ -23,40 +24,56 @@ const char* stateToString(MachineState state) {
     case CUTTING: return "CUTTING";
     case YES_WOOD: return "YES_WOOD";
     case NO_WOOD: return "NO_WOOD";
+    case READY: return "READY";
+    case ERROR: return "ERROR";
+    case BENCHMARK: return "BENCHMARK";
     default: return "UNKNOWN_STATE";
   }
 }
 
-void initializeStateMachine() {
+void initializeStateMachine(Station& station) {
     // Explicitly set initial state to HOMING
-    currentState = HOMING;
-    Serial.println("State Machine Initialized. Current state: HOMING");
+    station.state = HOMING;
+    Serial.print("State Machine Initialized for station "); Serial.print(station.id);
+    Serial.println(". Current state: HOMING");
+    enterHomingState(station);
 }
 
-void transitionToState(MachineState newState) {
-    Serial.print("STATE TRANSITION: From ");
-    Serial.print(stateToString(currentState));
+void transitionToState(Station& station, MachineState newState) {
+    Serial.print("STATE TRANSITION [S"); Serial.print(station.id); Serial.print("]: From ");
+    Serial.print(stateToString(station.state));
     Serial.print(" -> ");
     Serial.println(stateToString(newState));
 
-    currentState = newState;
+    recordStateTransition(station, station.state, newState);
+    traceEvent(station.id, TRACE_STATE, newState, 0);
+    station.state = newState;
+    setStationStep(station, 0);
 
-    switch (currentState) {
+    switch (station.state) {
         case IDLE:
-            enterIdleState();
+            enterIdleState(station);
             break;
         case HOMING:
-            // enterHomingState(); // If Homing becomes a re-enterable state managed by SM
+            enterHomingState(station);
             break;
         case CUTTING:
-            performCutCycle(); // Call the cutting cycle function
+            performCutCycle(station); // Starts the cutting cycle
             break;
         case YES_WOOD:
             // enterYesWoodState(); // Old function call
-            showYesWoodIndicator(); // New function for YesWood state entry/indication
+            showYesWoodIndicator(station); // New function for YesWood state entry/indication
             break;
         case NO_WOOD:
-            enterNoWoodState();
+            enterNoWoodState(station);
+            break;
+        case ERROR:
+            Serial.print("ERROR: Station "); Serial.print(station.id);
+            Serial.print(" stopped with error code ");
+            Serial.println((int)station.error);
+            break;
+        case BENCHMARK:
+            enterStepBenchmark(station);
             break;
         // Add cases for other states and call their entry functions
         default:
@@ -65,23 +82,29 @@ void transitionToState(MachineState newState) {
     }
 }
 
-void runStateMachine() {
-    switch (currentState) {
+void runStateMachine(Station& station) {
+    switch (station.state) {
         case IDLE:
-            runIdleState();
+            runIdleState(station);
             break;
         case HOMING:
-            // runHomingLoop(); // If homing were an SM managed loop
+            runHomingState(station);
             break;
         case CUTTING:
-            // runCuttingState(); // Now handled by performCutCycle on entry
+            runCuttingState(station);
             break;
         case YES_WOOD:
             // runYesWoodState(); // Old function call
-            handleYesWoodState(); // New function for YesWood state logic
+            handleYesWoodState(station); // New function for YesWood state logic
             break;
         case NO_WOOD:
-            runNoWoodState();
+            runNoWoodState(station);
+            break;
+        case ERROR:
+            // Wait for a 'rehome' from the console
+            break;
+        case BENCHMARK:
+            runStepBenchmark(station);
             break;
         // Add cases for other states
         default:
@@ -89,12 +112,3 @@ void runStateMachine() {
             break;
     }
 }
-
-// --- Utility Functions ---
-bool Wait(unsigned long interval, unsigned long* startTime) {
-  if (millis() - *startTime >= interval) {
-    *startTime = millis(); // Reset start time for the next potential wait or just to update
-    return true; // Interval has passed
-  }
-  return false; // Interval has not passed
-} 
\ No newline at end of file
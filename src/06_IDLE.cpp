@@ -1,5 +1,6 @@
 #include "Idle.h"
 #include "settings.h"
+#include "Station.h"
 #include "StateMachine.h" // For potential future transitions out of IDLE
 #include <Arduino.h> // For Serial
 #include <Bounce2.h> // Include Bounce2 library
@@ -9,25 +10,28 @@
 //* ************************************************************************
 // This file contains the definitions for the IDLE state functions.
 
-Bounce cycleSwitch = Bounce(); // Create a Bounce object for the cycle switch
-
-void enterIdleState() {
-  Serial.println("ENTERING IDLE STATE");
+void enterIdleState(Station& station) {
+  Serial.print("ENTERING IDLE STATE [S"); Serial.print(station.id); Serial.println("]");
   // Perform any actions needed when entering IDLE state
   // e.g., turn off motors, set status LEDs
 
-  // Setup Cycle Switch
-  cycleSwitch.attach(CYCLE_SWITCH_PIN, INPUT_PULLDOWN);
-  cycleSwitch.interval(25); // Debounce interval of 25ms
+  // Setup Cycle Switch (pin mode is set up in initializeStations())
+  station.cycleSwitch.attach(station.pins->cycleSwitch);
+  station.cycleSwitch.interval(25); // Debounce interval of 25ms
   Serial.println("IDLE: Cycle switch initialized.");
 }
 
-void runIdleState() {
-  cycleSwitch.update(); // Update the Bounce object
+void runIdleState(Station& station) {
+  station.cycleSwitch.update(); // Update the Bounce object
 
-  if (cycleSwitch.read() == HIGH) { // If cycle switch is pressed (HIGH)
-    Serial.println("IDLE: Cycle switch activated. Transitioning to CUTTING.");
-    transitionToState(CUTTING);
+  if (station.cycleSwitch.read() == HIGH) { // If cycle switch is pressed (HIGH)
+    if (!areAxesStopped(station)) {
+      // A console jog is still running; the cut starts once it has finished
+      if (station.cycleSwitch.rose()) Serial.println("IDLE: Cycle switch held until the axes stop.");
+    } else {
+      Serial.println("IDLE: Cycle switch activated. Transitioning to CUTTING.");
+      transitionToState(station, CUTTING);
+    }
   }
   // Other idle tasks can go here, but avoid blocking delays
-} 
\ No newline at end of file
+}
@@ -0,0 +1,267 @@
+#include "Stats.h"
+#include "settings.h"
+#include "Station.h"
+#include <Arduino.h>
+#include <Preferences.h> // ESP32 NVS key/value storage
+
+//* ************************************************************************
+//* ****************************** STATS *********************************
+//* ************************************************************************
+// This file contains the definitions for the shift-level throughput and
+// availability accounting. All updates are constant time. Counters live in RAM
+// and each station's are written to NVS as one blob: within
+// STATS_CYCLE_SAVE_DELAY_MS of a cycle ending (one write covers every cycle in
+// between), every STATS_SAVE_INTERVAL_MS while time accrues otherwise, and at
+// once on a reset. A flash write stalls the cache, so a due save waits until
+// no axis is moving, for at most STATS_SAVE_MAX_DEFERRALS retries.
+//
+// Write budget: the 56-byte blob takes 4 NVS entries per write. The default
+// 20 KB partition has 5 pages of 126 entries, so each page is erased about
+// once every 157 writes, and 100k erase cycles allow some 15 million writes.
+// At one write per 2 minutes per station, producing around the clock, two
+// stations make 1440 writes a day: about 30 years.
+
+static const uint32_t STATS_VERSION = 1;
+
+static Preferences statsPrefs;
+
+static const size_t STATS_KEY_LENGTH = 12;
+static const uint8_t STATS_BUCKETS = STATS_WINDOW_MINUTES + 1;
+
+// NVS key of a station's counters: "shift0", "shift1", ...
+static void statsKey(const Station& station, char* key) {
+  snprintf(key, STATS_KEY_LENGTH, "shift%u", station.id);
+}
+
+// Clears the buckets for any minutes that passed since the last update.
+// Bounded by STATS_BUCKETS iterations, so still constant time.
+static void advanceBuckets(StationStats& stats, unsigned long now) {
+  uint32_t minute = now / 60000UL;
+  uint32_t elapsed = minute - stats.bucketMinute;
+  if (elapsed == 0) return;
+  if (elapsed > STATS_BUCKETS) elapsed = STATS_BUCKETS;
+  for (uint32_t i = 1; i <= elapsed; i++) {
+    stats.cycleBuckets[(stats.bucketMinute + i) % STATS_BUCKETS] = 0;
+  }
+  stats.bucketMinute = minute;
+}
+
+// Empties the rolling windows; the minute in progress is only partly covered
+static void clearBuckets(StationStats& stats, unsigned long now) {
+  memset(stats.cycleBuckets, 0, sizeof(stats.cycleBuckets));
+  stats.bucketMinute = now / 60000UL;
+  stats.firstFullMinute = stats.bucketMinute + 1;
+}
+
+// States that make up a cut cycle, from the stroke to its outcome
+static bool isCycleState(MachineState state) {
+  return state == CUTTING || state == YES_WOOD || state == NO_WOOD;
+}
+
+// Adds time spent in a state to the matching availability counter
+static void accumulateStateTime(ShiftStats& shift, MachineState state, unsigned long durationMs) {
+  switch (state) {
+    case IDLE:
+      shift.idleMs += durationMs;
+      break;
+    case HOMING:
+      shift.homingMs += durationMs;
+      break;
+    case ERROR:
+    case BENCHMARK:
+      break; // Faulted and maintenance time counts as neither idle nor producing
+    default:
+      shift.producingMs += durationMs; // READY, CUTTING, YES_WOOD, NO_WOOD
+      break;
+  }
+}
+
+// Time in the current state that the next save would add to the counters
+static bool hasUnsavedTime(const Station& station) {
+  if (station.state == ERROR || station.state == BENCHMARK) return false; // Not counted
+  return millis() != station.stats.stateEnteredAt;
+}
+
+static bool anyAxisMoving() {
+  for (const Station& station : stations) {
+    if (!areAxesStopped(station)) return true;
+  }
+  return false;
+}
+
+// A save is due. Put it off while an axis moves, and skip it when nothing
+// changed; either way look again later.
+static void onSaveTimer(void* arg) {
+  Station& station = *(Station*)arg;
+  StationStats& stats = station.stats;
+  if (!stats.dirty && !hasUnsavedTime(station)) {
+    armTimer(stats.saveTimer, STATS_SAVE_INTERVAL_MS);
+  } else if (anyAxisMoving() && stats.saveDeferrals < STATS_SAVE_MAX_DEFERRALS) {
+    stats.saveDeferrals++;
+    armTimer(stats.saveTimer, STATS_SAVE_RETRY_MS);
+  } else {
+    saveStats(station);
+  }
+}
+
+void initializeStats() {
+  statsPrefs.begin("stats", false);
+  unsigned long now = millis();
+
+  for (Station& station : stations) {
+    StationStats& stats = station.stats;
+    char key[STATS_KEY_LENGTH];
+    statsKey(station, key);
+    size_t len = statsPrefs.getBytes(key, &stats.shift, sizeof(stats.shift));
+    if (len != sizeof(stats.shift) || stats.shift.version != STATS_VERSION) {
+      Serial.print("STATS: No valid stored counters for station "); Serial.print(station.id);
+      Serial.println(", starting a new shift.");
+      memset(&stats.shift, 0, sizeof(stats.shift));
+      stats.shift.version = STATS_VERSION;
+    }
+    stats.shift.bootCount++;
+    stats.dirty = true;
+
+    stats.stateEnteredAt = now; // Stations boot into HOMING
+    stats.saveDeferrals = 0;
+    setupTimer(stats.saveTimer, "stats save", onSaveTimer, &station);
+    armTimer(stats.saveTimer, STATS_SAVE_INTERVAL_MS);
+    clearBuckets(stats, now);
+  }
+}
+
+void recordStateTransition(Station& station, MachineState oldState, MachineState newState) {
+  StationStats& stats = station.stats;
+  unsigned long now = millis();
+  unsigned long duration = now - stats.stateEnteredAt;
+  stats.stateEnteredAt = now;
+
+  accumulateStateTime(stats.shift, oldState, duration);
+  if (oldState == HOMING && newState != HOMING) {
+    stats.shift.homingCount++;
+    stats.shift.lastHomingMs = duration;
+  }
+
+  // A cycle's outcome is decided on leaving CUTTING
+  switch (newState) {
+    case YES_WOOD:
+      stats.shift.yesWoodCycles++;
+      break;
+    case NO_WOOD:
+      stats.shift.noWoodCycles++;
+      break;
+    case ERROR:
+      // Only faults during a cycle; homing failures and aborted benchmarks are not cycles
+      if (isCycleState(oldState)) stats.shift.errorCycles++;
+      break;
+    default:
+      break;
+  }
+  if (newState == YES_WOOD || newState == NO_WOOD) {
+    advanceBuckets(stats, now);
+    stats.cycleBuckets[stats.bucketMinute % STATS_BUCKETS]++;
+  }
+  stats.dirty = true;
+
+  if (isCycleState(oldState) && !isCycleState(newState)) {
+    armTimerWithin(stats.saveTimer, STATS_CYCLE_SAVE_DELAY_MS);
+  }
+}
+
+void serviceStats() {
+  unsigned long now = millis();
+  for (Station& station : stations) {
+    StationStats& stats = station.stats;
+    advanceBuckets(stats, now);
+  }
+}
+
+void saveStats(Station& station) {
+  StationStats& stats = station.stats;
+
+  // Fold the time spent in the current state so far into the counters
+  unsigned long now = millis();
+  accumulateStateTime(stats.shift, station.state, now - stats.stateEnteredAt);
+  stats.stateEnteredAt = now;
+
+  char key[STATS_KEY_LENGTH];
+  statsKey(station, key);
+  statsPrefs.putBytes(key, &stats.shift, sizeof(stats.shift));
+  stats.dirty = false;
+  stats.saveDeferrals = 0;
+  armTimer(stats.saveTimer, STATS_SAVE_INTERVAL_MS);
+}
+
+void resetStats(Station& station) {
+  StationStats& stats = station.stats;
+  uint32_t bootCount = stats.shift.bootCount;
+  memset(&stats.shift, 0, sizeof(stats.shift));
+  stats.shift.version = STATS_VERSION;
+  stats.shift.bootCount = bootCount;
+  clearBuckets(stats, millis());
+  stats.stateEnteredAt = millis();
+  saveStats(station);
+  Serial.print("STATS: Station "); Serial.print(station.id);
+  Serial.println(" counters reset for a new shift.");
+}
+
+uint32_t getCyclesInWindow(Station& station, uint8_t windowMinutes, uint8_t* spanMinutes) {
+  StationStats& stats = station.stats;
+  if (windowMinutes > STATS_WINDOW_MINUTES) windowMinutes = STATS_WINDOW_MINUTES;
+  advanceBuckets(stats, millis());
+
+  // Complete minutes only: from the one before the current bucket backwards
+  uint32_t fullMinutes = (int32_t)(stats.bucketMinute - stats.firstFullMinute) > 0
+                             ? stats.bucketMinute - stats.firstFullMinute : 0;
+  uint8_t span = fullMinutes < windowMinutes ? (uint8_t)fullMinutes : windowMinutes;
+  uint32_t total = 0;
+  for (uint8_t i = 1; i <= span; i++) {
+    total += stats.cycleBuckets[(stats.bucketMinute + STATS_BUCKETS - i) % STATS_BUCKETS];
+  }
+  if (spanMinutes) *spanMinutes = span;
+  return total;
+}
+
+void printStats(Station& station) {
+  const ShiftStats& shift = station.stats.shift;
+
+  // Include the time spent in the current state without mutating the counters
+  MachineState state = station.state;
+  unsigned long inState = millis() - station.stats.stateEnteredAt;
+  uint64_t idleMs = shift.idleMs + (state == IDLE ? inState : 0);
+  uint64_t homingMs = shift.homingMs + (state == HOMING ? inState : 0);
+  uint64_t producingMs = shift.producingMs;
+  if (state != IDLE && state != HOMING && state != ERROR && state != BENCHMARK) {
+    producingMs += inState;
+  }
+  uint64_t availableMs = idleMs + producingMs;
+
+  Serial.print("==== SHIFT STATS (station "); Serial.print(station.id); Serial.println(") ====");
+  Serial.print("Cycles YES_WOOD: "); Serial.println(shift.yesWoodCycles);
+  Serial.print("Cycles NO_WOOD: "); Serial.println(shift.noWoodCycles);
+  Serial.print("Cycles ERROR: "); Serial.println(shift.errorCycles);
+  Serial.print("Idle time (s): "); Serial.println((uint32_t)(idleMs / 1000));
+  Serial.print("Producing time (s): "); Serial.println((uint32_t)(producingMs / 1000));
+  Serial.print("Idle fraction: ");
+  Serial.println(availableMs ? (float)idleMs / (float)availableMs : 0.0f, 3);
+
+  // Rolling throughput over complete minutes, scaled by the minutes actually covered
+  const uint8_t windows[] = {1, 15, 60};
+  for (uint8_t w : windows) {
+    uint8_t span;
+    uint32_t cycles = getCyclesInWindow(station, w, &span);
+    Serial.print("Throughput "); Serial.print(w); Serial.print(" min: ");
+    Serial.print(cycles); Serial.print(" cycles");
+    if (span == 0) {
+      Serial.println(" (no complete minute yet)");
+    } else {
+      if (span < w) { Serial.print(" in "); Serial.print(span); Serial.print(" min"); }
+      Serial.print(" ("); Serial.print(cycles * 60 / span); Serial.println("/h)");
+    }
+  }
+
+  Serial.print("Homing count: "); Serial.println(shift.homingCount);
+  Serial.print("Homing total (ms): "); Serial.println((uint32_t)homingMs);
+  Serial.print("Last homing (ms): "); Serial.println(shift.lastHomingMs);
+  Serial.print("Boot count: "); Serial.println(shift.bootCount);
+}
@@ -0,0 +1,188 @@
+#include "Trace.h"
+#include "settings.h"
+#include "StateMachine.h"
+#include "Station.h"
+#include "Clamps.h"
+#include <Arduino.h>
+#include <FastAccelStepper.h>
+
+//* ************************************************************************
+//* ****************************** TRACE *********************************
+//* ************************************************************************
+// This file contains the definitions for the input/event trace capture.
+// Input edges are recorded from GPIO interrupts so that the timing is that of
+// the sensors, not of the code polling them. When the buffer is full further
+// events are dropped (and counted) so a trace always starts at capture start.
+// A capture records the input levels, axis positions and state of every
+// station when it starts, so one started mid-run can still be replayed.
+// A dump is sent a few lines per loop pass, only as fast as the Serial
+// buffer drains, so the stations keep running while it goes out. Recording
+// is paused meanwhile and events that arrive are counted as dropped.
+
+static TraceEvent traceBuffer[TRACE_BUFFER_EVENTS];
+static volatile size_t traceCount = 0;
+static volatile uint32_t traceDropped = 0;
+static volatile bool traceCapturing = false;
+static volatile bool tracePaused = false;     // Capturing, but frozen while a dump is sent
+static bool traceAtBoot = false;              // Capture was started from setup()
+static uint32_t traceStartTime = 0;
+static portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Dump in progress: next buffer index to send, -1 for the BEGIN line
+static bool traceDumping = false;
+static long dumpIndex = 0;
+static uint32_t dumpLastTime = 0;
+
+static const uint8_t MAX_TRACED_INPUTS_PER_STATION = 4 + CLAMP_VALVE_COUNT;
+static const uint8_t TRACE_DUMP_LINES_PER_PASS = 4;
+static const int TRACE_DUMP_LINE_MAX = 40;    // Longest export line, with margin
+
+// Inputs of a station whose edges are captured: the switches, the wood
+// sensor and the clamp feedback sensors the clamp driver reads
+static uint8_t tracedInputPins(const Station& station, uint8_t* pins) {
+  uint8_t count = 0;
+  pins[count++] = station.pins->cutMotorHomingSwitch;
+  pins[count++] = station.pins->positionMotorHomingSwitch;
+  pins[count++] = station.pins->woodSensor;
+  pins[count++] = station.pins->cycleSwitch;
+  for (const ClampDriver& clamp : station.clamps) {
+    if (clamp.feedbackPin != CLAMP_NO_PIN) pins[count++] = clamp.feedbackPin;
+  }
+  return count;
+}
+
+static void IRAM_ATTR appendEvent(uint8_t station, uint8_t type, uint8_t id, int32_t value) {
+  if (!traceCapturing) return;
+  if (tracePaused) {
+    traceDropped++;
+    return;
+  }
+  if (traceCount >= TRACE_BUFFER_EVENTS) {
+    traceDropped++;
+    return;
+  }
+  TraceEvent& e = traceBuffer[traceCount];
+  e.timeUs = micros();
+  e.value = value;
+  e.type = type;
+  e.id = id;
+  e.station = station;
+  traceCount++;
+}
+
+// arg packs (station << 8) | pin
+static void IRAM_ATTR onInputEdge(void* arg) {
+  uint8_t pin = (uint8_t)(uintptr_t)arg;
+  uint8_t station = (uint8_t)((uintptr_t)arg >> 8);
+  portENTER_CRITICAL_ISR(&traceMux);
+  appendEvent(station, TRACE_INPUT_EDGE, pin, digitalRead(pin));
+  portEXIT_CRITICAL_ISR(&traceMux);
+}
+
+void initializeTrace() {
+  for (Station& station : stations) {
+    uint8_t pins[MAX_TRACED_INPUTS_PER_STATION];
+    uint8_t count = tracedInputPins(station, pins);
+    for (uint8_t i = 0; i < count; i++) {
+      uintptr_t arg = ((uintptr_t)station.id << 8) | pins[i];
+      attachInterruptArg(digitalPinToInterrupt(pins[i]), onInputEdge, (void*)arg, CHANGE);
+    }
+  }
+  if (TRACE_CAPTURE_AT_BOOT) {
+    startTraceCapture();
+    traceAtBoot = true;
+  }
+}
+
+static void traceAxisPosition(const Station& station, TraceAxis axis, FastAccelStepper* stepper) {
+  if (stepper) traceEvent(station.id, TRACE_START_POSITION, axis, stepper->getCurrentPosition());
+}
+
+void startTraceCapture() {
+  if (traceDumping) {
+    Serial.println("ERR: Trace dump in progress.");
+    return;
+  }
+  portENTER_CRITICAL(&traceMux);
+  traceCount = 0;
+  traceDropped = 0;
+  traceStartTime = micros();
+  traceAtBoot = false;
+  tracePaused = false;
+  traceCapturing = true;
+  portEXIT_CRITICAL(&traceMux);
+
+  // Record the starting conditions so a replay can reproduce them
+  for (Station& station : stations) {
+    uint8_t pins[MAX_TRACED_INPUTS_PER_STATION];
+    uint8_t count = tracedInputPins(station, pins);
+    for (uint8_t i = 0; i < count; i++) {
+      traceEvent(station.id, TRACE_INPUT_LEVEL, pins[i], digitalRead(pins[i]));
+    }
+    traceAxisPosition(station, TRACE_AXIS_CUT, station.cutMotor);
+    traceAxisPosition(station, TRACE_AXIS_POSITION, station.positionMotor);
+    traceEvent(station.id, TRACE_STATE, station.state, 0);
+  }
+  Serial.println("TRACE: Capture started.");
+}
+
+void stopTraceCapture() {
+  traceCapturing = false;
+  Serial.println("TRACE: Capture stopped.");
+}
+
+void traceEvent(uint8_t station, TraceEventType type, uint8_t id, int32_t value) {
+  portENTER_CRITICAL(&traceMux);
+  appendEvent(station, type, id, value);
+  portEXIT_CRITICAL(&traceMux);
+}
+
+// Export format, one event per line with the time as a delta to the previous event:
+//   T BEGIN <count> <dropped> <startUs> <atBoot>
+//   T <deltaUs> <type> <id> <value> <station>
+//   T END <dropped>
+// The END count includes events dropped while the dump was being sent.
+void dumpTrace() {
+  if (traceDumping) return;
+  tracePaused = true; // Freeze the buffer while it is sent
+  traceDumping = true;
+  dumpIndex = -1;
+  dumpLastTime = traceStartTime;
+}
+
+bool isTraceDumping() {
+  return traceDumping;
+}
+
+void serviceTrace() {
+  if (!traceDumping) return;
+  for (uint8_t line = 0; line < TRACE_DUMP_LINES_PER_PASS; line++) {
+    if (Serial.availableForWrite() < TRACE_DUMP_LINE_MAX) return; // Never wait on the port
+
+    if (dumpIndex < 0) {
+      Serial.print("T BEGIN "); Serial.print((uint32_t)traceCount);
+      Serial.print(" "); Serial.print(traceDropped);
+      Serial.print(" "); Serial.print(traceStartTime);
+      Serial.print(" "); Serial.println(traceAtBoot ? 1 : 0);
+    } else if ((size_t)dumpIndex < traceCount) {
+      const TraceEvent& e = traceBuffer[dumpIndex];
+      Serial.print("T "); Serial.print(e.timeUs - dumpLastTime);
+      Serial.print(" "); Serial.print((char)e.type);
+      Serial.print(" "); Serial.print(e.id);
+      Serial.print(" "); Serial.print(e.value);
+      Serial.print(" "); Serial.println(e.station);
+      dumpLastTime = e.timeUs;
+    } else {
+      Serial.print("T END "); Serial.println(traceDropped);
+      traceDumping = false;
+      tracePaused = false;
+      return;
+    }
+    dumpIndex++;
+  }
+}
+
+const TraceEvent* getTraceEvents(size_t* count) {
+  *count = traceCount;
+  return traceBuffer;
+}
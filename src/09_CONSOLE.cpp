@@ -0,0 +1,321 @@
+#include "Console.h"
+#include "settings.h"
+#include "StateMachine.h"
+#include "Homing.h"
+#include "Stats.h"
+#include "Trace.h"
+#include "Boot.h"
+#include "Station.h"
+#include "Timers.h"
+#include "StepBench.h"
+#include "Motion.h"
+#include "Clamps.h"
+#include <Arduino.h>
+#include <FastAccelStepper.h>
+#include <strings.h> // strcasecmp
+
+//* ************************************************************************
+//* ***************************** CONSOLE ********************************
+//* ************************************************************************
+// This file contains the definitions for the serial command console.
+// Input is collected one byte per loop() pass into a fixed buffer and parsed
+// in place when the line ends, so the console never allocates and never
+// holds up the state machine.
+
+static const size_t CONSOLE_LINE_LENGTH = 64;
+
+static char lineBuffer[CONSOLE_LINE_LENGTH];
+static size_t lineLength = 0;
+static bool lineOverflow = false;
+static uint8_t selectedStation = 0; // Station that jog/home/cycle/set/stats act on
+
+static Station& station() {
+  return stations[selectedStation];
+}
+
+// Runtime-tunable motion profile values of the selected station, named
+// PROFILE.AXIS.FIELD (e.g. stroke.cut.accel) with AXIS cut|pos and FIELD
+// speed|accel|jerk. A jerk of 0 is allowed and turns the S-curve off; on a
+// coordinated profile it is the only jerk allowed.
+static float* findSetting(const char* name, bool* zeroAllowed, bool* zeroOnly) {
+  char buffer[CONSOLE_LINE_LENGTH];
+  strncpy(buffer, name, sizeof(buffer) - 1);
+  buffer[sizeof(buffer) - 1] = '\0';
+
+  char* save;
+  char* profileName = strtok_r(buffer, ".", &save);
+  char* axisName = strtok_r(NULL, ".", &save);
+  char* fieldName = strtok_r(NULL, ".", &save);
+  if (!profileName || !axisName || !fieldName) return NULL;
+
+  MotionProfile* profile = findMotionProfile(station(), profileName);
+  if (!profile) return NULL;
+  AxisProfile* axis = NULL;
+  if (strcasecmp(axisName, "cut") == 0) axis = &profile->cut;
+  else if (strcasecmp(axisName, "pos") == 0) axis = &profile->position;
+  if (!axis) return NULL;
+
+  *zeroAllowed = false;
+  *zeroOnly = false;
+  if (strcasecmp(fieldName, "speed") == 0) return &axis->speed;
+  if (strcasecmp(fieldName, "accel") == 0) return &axis->acceleration;
+  if (strcasecmp(fieldName, "jerk") == 0) {
+    *zeroAllowed = true;
+    *zeroOnly = isCoordinatedMoveKind((MoveKind)(profile - station().profiles));
+    return &axis->jerk;
+  }
+  return NULL;
+}
+
+static void printSetting(const char* name, float value) {
+  Serial.print(name); Serial.print(" = "); Serial.println(value, 0);
+}
+
+// Jog, home and cycle commands are only accepted while the station is idle
+// and no axis is still moving from an earlier jog
+static bool requireIdle() {
+  if (station().state != IDLE) {
+    Serial.print("ERR: Station "); Serial.print(selectedStation);
+    Serial.print(" busy in state "); Serial.println(stateToString(station().state));
+    return false;
+  }
+  if (!areAxesStopped(station())) {
+    Serial.print("ERR: Station "); Serial.print(selectedStation); Serial.println(" axis still moving");
+    return false;
+  }
+  return true;
+}
+
+static void printHelp() {
+  Serial.println("Commands:");
+  Serial.println("  station [n]               Show or select the station the commands act on");
+  Serial.println("  state                     Show state, error and axis positions of all stations");
+  Serial.println("  jog cut|pos <inches>      Relative move at normal speed, limited to the travel (IDLE only)");
+  Serial.println("  home cut|pos              Re-home one axis (IDLE only)");
+  Serial.println("  rehome                    Run the full homing sequence (IDLE or ERROR)");
+  Serial.println("  cycle                     Start a cut cycle (IDLE only)");
+  Serial.println("  bench                     Step generation stress benchmark (IDLE only, blade off)");
+  Serial.println("  get [PROFILE.AXIS.FIELD]  Show motion profiles and their recorded move durations");
+  Serial.println("  set PROFILE.AXIS.FIELD V  Change a profile value (e.g. nudge.pos.jerk); applies from the next move");
+  Serial.println("  stats [reset]             Show or reset shift statistics");
+  Serial.println("  trace start|stop|dump     Control the input/event trace capture");
+  Serial.println("  boot                      Show the boot timeline");
+  Serial.println("  timers                    Show armed timers and how late they fired");
+  Serial.println("  clamps [reset]            Show clamp drive settings and actuation latencies");
+}
+
+static void printState() {
+  for (Station& each : stations) {
+    Serial.print("Station "); Serial.print(each.id);
+    Serial.println(each.id == selectedStation ? " (selected)" : "");
+    Serial.print("  State: "); Serial.println(stateToString(each.state));
+    Serial.print("  Error: "); Serial.println((int)each.error);
+    if (each.cutMotor) {
+      Serial.print("  Cut motor position (in): ");
+      Serial.println(each.cutMotor->getCurrentPosition() / CUT_MOTOR_STEPS_PER_INCH, 3);
+    }
+    if (each.positionMotor) {
+      Serial.print("  Position motor position (in): ");
+      Serial.println(each.positionMotor->getCurrentPosition() / POSITION_MOTOR_STEPS_PER_INCH, 3);
+    }
+  }
+}
+
+static void selectStation(const char* idArg) {
+  if (idArg) {
+    char* end;
+    long id = strtol(idArg, &end, 10);
+    if (*end != '\0' || id < 0 || id >= STATION_COUNT) {
+      Serial.println("ERR: Unknown station");
+      return;
+    }
+    selectedStation = (uint8_t)id;
+  }
+  Serial.print("Station: "); Serial.println(selectedStation);
+}
+
+static void jogAxis(const char* axis, const char* distanceArg) {
+  if (!axis || !distanceArg) {
+    Serial.println("ERR: Usage: jog cut|pos <inches>");
+    return;
+  }
+  if (!requireIdle()) return;
+
+  char* end;
+  float inches = strtof(distanceArg, &end);
+  if (*end != '\0') {
+    Serial.println("ERR: Invalid distance");
+    return;
+  }
+
+  Station& target = station();
+  TraceAxis traceAxis;
+  FastAccelStepper* stepper;
+  float stepsPerInch, travel;
+  if (strcasecmp(axis, "cut") == 0 && target.cutMotor) {
+    traceAxis = TRACE_AXIS_CUT;
+    stepper = target.cutMotor;
+    stepsPerInch = CUT_MOTOR_STEPS_PER_INCH;
+    travel = CUT_MOTOR_TRAVEL_DISTANCE;
+  } else if (strcasecmp(axis, "pos") == 0 && target.positionMotor) {
+    traceAxis = TRACE_AXIS_POSITION;
+    stepper = target.positionMotor;
+    stepsPerInch = POSITION_MOTOR_STEPS_PER_INCH;
+    travel = POSITION_MOTOR_TRAVEL_DISTANCE;
+  } else {
+    Serial.println("ERR: Unknown axis");
+    return;
+  }
+
+  // Keep the target within the homed travel, 0 .. TRAVEL_DISTANCE
+  float targetInches = stepper->getCurrentPosition() / stepsPerInch + inches;
+  float limited = constrain(targetInches, 0.0f, travel);
+  startProfileMove(target, traceAxis, MOVE_FEED, lroundf(limited * stepsPerInch));
+  if (limited != targetInches) {
+    Serial.print("OK, limited to "); Serial.print(limited, 3); Serial.println(" in");
+  } else {
+    Serial.println("OK");
+  }
+}
+
+static void homeAxis(const char* axis) {
+  if (!axis) {
+    Serial.println("ERR: Usage: home cut|pos");
+    return;
+  }
+  if (!requireIdle()) return;
+
+  if (strcasecmp(axis, "cut") == 0) {
+    homeCutMotor(station());
+  } else if (strcasecmp(axis, "pos") == 0) {
+    homePositionMotor(station());
+  } else {
+    Serial.println("ERR: Unknown axis");
+    return;
+  }
+  Serial.println("OK");
+}
+
+static void getSettings(const char* name) {
+  if (!name) {
+    printMotionProfiles(station());
+    return;
+  }
+  bool zeroAllowed, zeroOnly;
+  float* value = findSetting(name, &zeroAllowed, &zeroOnly);
+  if (value) printSetting(name, *value);
+  else Serial.println("ERR: Unknown setting");
+}
+
+static void setSetting(const char* name, const char* valueArg) {
+  if (!name || !valueArg) {
+    Serial.println("ERR: Usage: set PROFILE.AXIS.FIELD VALUE");
+    return;
+  }
+  bool zeroAllowed, zeroOnly;
+  float* setting = findSetting(name, &zeroAllowed, &zeroOnly);
+  if (!setting) {
+    Serial.println("ERR: Unknown setting");
+    return;
+  }
+  char* end;
+  float value = strtof(valueArg, &end);
+  if (*end != '\0' || value < 0 || (value == 0 && !zeroAllowed)) {
+    Serial.println("ERR: Value must be a positive number");
+    return;
+  }
+  if (zeroOnly && value != 0) {
+    Serial.println("ERR: Coordinated moves run without S-curve; their jerk must stay 0");
+    return;
+  }
+  *setting = value;
+  printSetting(name, *setting);
+}
+
+static void executeLine(char* line) {
+  char* save;
+  char* command = strtok_r(line, " \t", &save);
+  if (!command) return;
+  char* arg1 = strtok_r(NULL, " \t", &save);
+  char* arg2 = strtok_r(NULL, " \t", &save);
+
+  if (strcasecmp(command, "help") == 0) {
+    printHelp();
+  } else if (strcasecmp(command, "station") == 0) {
+    selectStation(arg1);
+  } else if (strcasecmp(command, "state") == 0) {
+    printState();
+  } else if (strcasecmp(command, "jog") == 0) {
+    jogAxis(arg1, arg2);
+  } else if (strcasecmp(command, "home") == 0) {
+    homeAxis(arg1);
+  } else if (strcasecmp(command, "rehome") == 0) {
+    if (station().state == IDLE || station().state == ERROR) {
+      station().error = NO_ERROR_EC;
+      Serial.println("OK");
+      transitionToState(station(), HOMING);
+    } else {
+      requireIdle();
+    }
+  } else if (strcasecmp(command, "cycle") == 0) {
+    if (requireIdle()) {
+      Serial.println("OK");
+      transitionToState(station(), CUTTING);
+    }
+  } else if (strcasecmp(command, "bench") == 0) {
+    if (requireIdle()) {
+      Serial.println("OK");
+      transitionToState(station(), BENCHMARK);
+    }
+  } else if (strcasecmp(command, "get") == 0) {
+    getSettings(arg1);
+  } else if (strcasecmp(command, "set") == 0) {
+    setSetting(arg1, arg2);
+  } else if (strcasecmp(command, "stats") == 0) {
+    if (arg1 && strcasecmp(arg1, "reset") == 0) resetStats(station());
+    else printStats(station());
+  } else if (strcasecmp(command, "trace") == 0) {
+    if (arg1 && strcasecmp(arg1, "start") == 0) startTraceCapture();
+    else if (arg1 && strcasecmp(arg1, "stop") == 0) stopTraceCapture();
+    else if (arg1 && strcasecmp(arg1, "dump") == 0) dumpTrace();
+    else Serial.println("ERR: Usage: trace start|stop|dump");
+  } else if (strcasecmp(command, "boot") == 0) {
+    printBootTimeline();
+  } else if (strcasecmp(command, "timers") == 0) {
+    printTimers();
+  } else if (strcasecmp(command, "clamps") == 0) {
+    if (arg1 && strcasecmp(arg1, "reset") == 0) {
+      resetClampLatencies(station());
+      Serial.println("OK");
+    } else {
+      printClamps(station());
+    }
+  } else {
+    Serial.print("ERR: Unknown command '"); Serial.print(command); Serial.println("', try 'help'");
+  }
+}
+
+void serviceConsole() {
+  serviceTrace(); // A dump in progress goes out a few lines per pass
+
+  int c = Serial.read();
+  if (c < 0) return;
+
+  if (c == '\n' || c == '\r') {
+    if (lineOverflow) {
+      Serial.println("ERR: Line too long");
+    } else if (lineLength > 0) {
+      lineBuffer[lineLength] = '\0';
+      executeLine(lineBuffer);
+    }
+    lineLength = 0;
+    lineOverflow = false;
+    return;
+  }
+
+  if (lineLength < CONSOLE_LINE_LENGTH - 1) {
+    lineBuffer[lineLength++] = (char)c;
+  } else {
+    lineOverflow = true; // Discard the rest of the line
+  }
+}
@@ -0,0 +1,49 @@
+#include "Boot.h"
+#include <Arduino.h>
+
+//* ************************************************************************
+//* ******************************* BOOT *********************************
+//* ************************************************************************
+// This file contains the definitions for the boot timeline. Phases are kept
+// in a small fixed table; timestamps are micros() since power-on.
+
+struct BootPhase {
+  const char* label;
+  uint32_t timeUs;
+};
+
+static const uint8_t MAX_BOOT_PHASES = 16;
+
+static BootPhase bootPhases[MAX_BOOT_PHASES];
+static uint8_t bootPhaseCount = 0;
+static bool bootComplete = false;
+
+void markBootPhase(const char* label) {
+  if (bootComplete || bootPhaseCount >= MAX_BOOT_PHASES) return;
+  bootPhases[bootPhaseCount].label = label;
+  bootPhases[bootPhaseCount].timeUs = micros();
+  bootPhaseCount++;
+}
+
+void completeBootTimeline() {
+  markBootPhase("ready");
+  bootComplete = true;
+}
+
+bool isBootComplete() {
+  return bootComplete;
+}
+
+void printBootTimeline() {
+  Serial.println("==== BOOT TIMELINE ====");
+  uint32_t previous = 0;
+  for (uint8_t i = 0; i < bootPhaseCount; i++) {
+    Serial.print(bootPhases[i].timeUs / 1000.0f, 1);
+    Serial.print(" ms (+");
+    Serial.print((bootPhases[i].timeUs - previous) / 1000.0f, 1);
+    Serial.print(") ");
+    Serial.println(bootPhases[i].label);
+    previous = bootPhases[i].timeUs;
+  }
+  if (!bootComplete) Serial.println("(startup still in progress)");
+}
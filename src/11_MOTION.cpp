@@ -0,0 +1,256 @@
+#include "Motion.h"
+#include "settings.h"
+#include "Trace.h"
+#include "Station.h"
+#include <Arduino.h>
+#include <FastAccelStepper.h>
+#include <strings.h> // strcasecmp
+
+//* ************************************************************************
+//* ****************************** MOTION ********************************
+//* ************************************************************************
+// This file contains the definitions for profiled and coordinated moves.
+//
+// S-curve: FastAccelStepper can raise the acceleration linearly over the
+// first N steps of a ramp instead of stepping straight to it. Ramping from 0
+// to a at jerk j takes a/j seconds and covers N = a³ / (6 j²) steps, so the
+// jerk of a profile maps to N for the acceleration actually used.
+//
+// For a trapezoidal move of distance d with ramp time ta and total time T:
+//   v = d / (T - ta),  a = v / ta
+// Each axis alone needs T_min = d/v_max + v_max/a_max (or 2*sqrt(d/a_max)
+// when it never reaches v_max). The joint time is the larger of the two (or
+// the budget), and each axis then takes the longest ramp that still fits,
+// which gives it the lowest acceleration and peak current for that time.
+
+static const float LIMIT_TOLERANCE = 1.001f; // Allow for float rounding in the checks
+
+static FastAccelStepper* axisStepper(Station& station, TraceAxis axis) {
+  return axis == TRACE_AXIS_CUT ? station.cutMotor : station.positionMotor;
+}
+
+static const AxisProfile& axisProfile(const MotionProfile& profile, TraceAxis axis) {
+  return axis == TRACE_AXIS_CUT ? profile.cut : profile.position;
+}
+
+// Steps of linear acceleration that limit the jerk to jerk at acceleration
+static uint32_t linearAccelerationSteps(float acceleration, float jerk) {
+  if (jerk <= 0) return 0;
+  float steps = acceleration * acceleration * acceleration / (6.0f * jerk * jerk);
+  return steps < 1.0f ? 1 : (uint32_t)steps;
+}
+
+// Shortest time for one axis to cover distance within its limits
+static float minimumMoveTime(float distance, AxisMoveLimits limits) {
+  if (distance <= 0) return 0;
+  float v = limits.maxSpeed;
+  float a = limits.maxAcceleration;
+  if (distance >= v * v / a) return distance / v + v / a;  // Reaches full speed
+  return 2.0f * sqrtf(distance / a);                       // Triangular profile
+}
+
+// Planned time of a single-axis move under profile. The S-curve start of each
+// ramp adds about half the time the acceleration takes to build up.
+static float plannedMoveTime(const AxisProfile& profile, long distance) {
+  float seconds = minimumMoveTime(fabsf((float)distance), {profile.speed, profile.acceleration});
+  if (profile.jerk > 0) seconds += profile.acceleration / profile.jerk;
+  return seconds;
+}
+
+static void recordDuration(ProfileDurations& durations, uint32_t us) {
+  if (durations.count == 0 || us < durations.minUs) durations.minUs = us;
+  if (us > durations.maxUs) durations.maxUs = us;
+  durations.totalUs += us;
+  durations.count++;
+}
+
+// Closes the axis's timed move if it finished; a move cut short by a new one is not counted
+static void finishActiveMove(Station& station, TraceAxis axis) {
+  ActiveMove& move = station.activeMoves[axis];
+  if (!move.active) return;
+  FastAccelStepper* stepper = axisStepper(station, axis);
+  if (stepper->isRunning()) return;
+  recordDuration(station.moveDurations[move.kind][axis], micros() - move.startUs);
+  move.active = false;
+}
+
+// Moves of zero distance are not timed
+static void beginActiveMove(Station& station, TraceAxis axis, MoveKind kind, long distance, float plannedSec) {
+  finishActiveMove(station, axis);
+  ActiveMove& move = station.activeMoves[axis];
+  move.plannedSec = distance == 0 ? 0 : plannedSec;
+  if (distance == 0) {
+    move.active = false;
+    return;
+  }
+  move.active = true;
+  move.kind = kind;
+  move.startUs = micros();
+}
+
+static bool applyProfile(Station& station, TraceAxis axis, MoveKind kind) {
+  FastAccelStepper* stepper = axisStepper(station, axis);
+  if (!stepper) {
+    Serial.println("ERROR: Profile move - stepper not initialized!");
+    return false;
+  }
+  const AxisProfile& profile = axisProfile(station.profiles[kind], axis);
+  stepper->setSpeedInHz(profile.speed);
+  stepper->setAcceleration(profile.acceleration);
+  stepper->setLinearAcceleration(linearAccelerationSteps(profile.acceleration, profile.jerk));
+  return true;
+}
+
+bool startProfileMove(Station& station, TraceAxis axis, MoveKind kind, long targetSteps) {
+  if (!applyProfile(station, axis, kind)) return false;
+  FastAccelStepper* stepper = axisStepper(station, axis);
+  long distance = targetSteps - stepper->getCurrentPosition();
+  beginActiveMove(station, axis, kind, distance,
+                  plannedMoveTime(axisProfile(station.profiles[kind], axis), distance));
+  stepper->moveTo(targetSteps);
+  traceEvent(station.id, TRACE_MOVE_TO, axis, targetSteps);
+  return true;
+}
+
+bool startProfileMoveBy(Station& station, TraceAxis axis, MoveKind kind, long steps) {
+  if (!applyProfile(station, axis, kind)) return false;
+  beginActiveMove(station, axis, kind, steps, plannedMoveTime(axisProfile(station.profiles[kind], axis), steps));
+  axisStepper(station, axis)->move(steps);
+  traceEvent(station.id, TRACE_MOVE, axis, steps);
+  return true;
+}
+
+// Speed and acceleration that make one axis take exactly duration seconds.
+// Returns false if that would exceed the axis limits.
+static bool fitAxisToDuration(float distance, float duration, AxisMoveLimits limits,
+                              float* speed, float* acceleration) {
+  if (distance <= 0) {
+    *speed = limits.maxSpeed;
+    *acceleration = limits.maxAcceleration;
+    return true;
+  }
+  float rampTime = min(duration / 2.0f, duration - distance / limits.maxSpeed);
+  if (rampTime <= 0) return false;
+  *speed = distance / (duration - rampTime);
+  *acceleration = *speed / rampTime;
+  return *speed <= limits.maxSpeed * LIMIT_TOLERANCE &&
+         *acceleration <= limits.maxAcceleration * LIMIT_TOLERANCE;
+}
+
+CoordinatedMove planCoordinatedMove(long cutDistanceSteps, long positionDistanceSteps,
+                                    AxisMoveLimits cutLimits, AxisMoveLimits positionLimits,
+                                    float timeBudgetSec) {
+  float cutDistance = fabsf((float)cutDistanceSteps);
+  float positionDistance = fabsf((float)positionDistanceSteps);
+
+  CoordinatedMove plan;
+  float minimumTime = max(minimumMoveTime(cutDistance, cutLimits),
+                          minimumMoveTime(positionDistance, positionLimits));
+  plan.durationSec = max(minimumTime, timeBudgetSec);
+
+  bool cutFits = fitAxisToDuration(cutDistance, plan.durationSec, cutLimits,
+                                   &plan.cutSpeed, &plan.cutAcceleration);
+  bool positionFits = fitAxisToDuration(positionDistance, plan.durationSec, positionLimits,
+                                        &plan.positionSpeed, &plan.positionAcceleration);
+  plan.achievable = cutFits && positionFits &&
+                    (timeBudgetSec <= 0 || minimumTime <= timeBudgetSec * LIMIT_TOLERANCE);
+  return plan;
+}
+
+bool startCoordinatedMove(Station& station, long cutTargetSteps, long positionTargetSteps, MoveKind kind,
+                          float timeBudgetSec, CoordinatedMove* planOut) {
+  FastAccelStepper* cutMotor = station.cutMotor;
+  FastAccelStepper* positionMotor = station.positionMotor;
+  if (!cutMotor || !positionMotor) {
+    Serial.println("ERROR: Coordinated move - stepper not initialized!");
+    return false;
+  }
+
+  const MotionProfile& profile = station.profiles[kind];
+  AxisMoveLimits cutLimits = {profile.cut.speed, profile.cut.acceleration};
+  AxisMoveLimits positionLimits = {profile.position.speed, profile.position.acceleration};
+
+  long cutDistance = cutTargetSteps - cutMotor->getCurrentPosition();
+  long positionDistance = positionTargetSteps - positionMotor->getCurrentPosition();
+  CoordinatedMove plan = planCoordinatedMove(cutDistance, positionDistance, cutLimits, positionLimits,
+                                             timeBudgetSec);
+  if (planOut) *planOut = plan;
+  if (!plan.achievable) {
+    Serial.println("ERROR: Coordinated move not achievable within the axis limits.");
+    return false;
+  }
+
+  // Milli-Hz keeps the speed rounding well below the acceleration rounding
+  cutMotor->setSpeedInMilliHz((uint32_t)(plan.cutSpeed * 1000.0f));
+  cutMotor->setAcceleration((int32_t)ceilf(plan.cutAcceleration));
+  positionMotor->setSpeedInMilliHz((uint32_t)(plan.positionSpeed * 1000.0f));
+  positionMotor->setAcceleration((int32_t)ceilf(plan.positionAcceleration));
+  // An S-curve would stretch each axis's ramps by a different time, and the
+  // axes would no longer arrive together
+  cutMotor->setLinearAcceleration(0);
+  positionMotor->setLinearAcceleration(0);
+
+  beginActiveMove(station, TRACE_AXIS_CUT, kind, cutDistance, plan.durationSec);
+  beginActiveMove(station, TRACE_AXIS_POSITION, kind, positionDistance, plan.durationSec);
+  cutMotor->moveTo(cutTargetSteps);
+  traceEvent(station.id, TRACE_MOVE_TO, TRACE_AXIS_CUT, cutTargetSteps);
+  positionMotor->moveTo(positionTargetSteps);
+  traceEvent(station.id, TRACE_MOVE_TO, TRACE_AXIS_POSITION, positionTargetSteps);
+  return true;
+}
+
+bool isCoordinatedMoveKind(MoveKind kind) {
+  return kind == MOVE_RETURN;
+}
+
+uint32_t moveTimeoutMs(float plannedSec) {
+  return (uint32_t)(plannedSec * MOVE_TIMEOUT_FACTOR * 1000.0f) + MOVE_TIMEOUT_MARGIN_MS;
+}
+
+uint32_t moveTimeoutMs(const Station& station, TraceAxis axis) {
+  return moveTimeoutMs(station.activeMoves[axis].plannedSec);
+}
+
+uint32_t moveTimeoutMs(const Station& station) {
+  return moveTimeoutMs(max(station.activeMoves[TRACE_AXIS_CUT].plannedSec,
+                           station.activeMoves[TRACE_AXIS_POSITION].plannedSec));
+}
+
+void serviceMotionProfiles() {
+  for (Station& station : stations) {
+    if (station.cutMotor) finishActiveMove(station, TRACE_AXIS_CUT);
+    if (station.positionMotor) finishActiveMove(station, TRACE_AXIS_POSITION);
+  }
+}
+
+MotionProfile* findMotionProfile(Station& station, const char* name) {
+  for (MotionProfile& profile : station.profiles) {
+    if (strcasecmp(profile.name, name) == 0) return &profile;
+  }
+  return NULL;
+}
+
+static void printAxisProfile(const char* axisName, const AxisProfile& profile, const ProfileDurations& durations) {
+  Serial.print("  "); Serial.print(axisName);
+  Serial.print(" speed "); Serial.print(profile.speed, 0);
+  Serial.print(" accel "); Serial.print(profile.acceleration, 0);
+  Serial.print(" jerk "); Serial.print(profile.jerk, 0);
+  Serial.print(" | moves "); Serial.print(durations.count);
+  if (durations.count) {
+    Serial.print(", mean/min/max ms ");
+    Serial.print(durations.totalUs / durations.count / 1000.0f, 1); Serial.print("/");
+    Serial.print(durations.minUs / 1000.0f, 1); Serial.print("/");
+    Serial.print(durations.maxUs / 1000.0f, 1);
+  }
+  Serial.println();
+}
+
+void printMotionProfiles(Station& station) {
+  Serial.print("==== MOTION PROFILES (station "); Serial.print(station.id); Serial.println(") ====");
+  for (uint8_t kind = 0; kind < MOVE_KIND_COUNT; kind++) {
+    const MotionProfile& profile = station.profiles[kind];
+    Serial.println(profile.name);
+    printAxisProfile("cut", profile.cut, station.moveDurations[kind][TRACE_AXIS_CUT]);
+    printAxisProfile("pos", profile.position, station.moveDurations[kind][TRACE_AXIS_POSITION]);
+  }
+}
@@ -0,0 +1,109 @@
+#include "Station.h"
+#include "settings.h"
+#include "Trace.h"
+#include <Arduino.h>
+#include <FastAccelStepper.h>
+
+//* ************************************************************************
+//* ***************************** STATION ********************************
+//* ************************************************************************
+// This file contains the definitions for the saw stations.
+
+Station stations[STATION_COUNT];
+
+// Connects a step pin on the preferred backend, falling back to the other one
+static FastAccelStepper* connectStepper(FastAccelStepperEngine& engine, uint8_t pin, uint8_t preferred,
+                                        uint8_t* backend) {
+  FastAccelStepper* stepper = engine.stepperConnectToPin(pin, preferred);
+  *backend = preferred;
+  if (!stepper) {
+    uint8_t fallback = (preferred == DRIVER_RMT) ? DRIVER_MCPWM_PCNT : DRIVER_RMT;
+    stepper = engine.stepperConnectToPin(pin, fallback);
+    *backend = fallback;
+    if (stepper) {
+      Serial.print("WARNING: No "); Serial.print(stepBackendName(preferred));
+      Serial.print(" channel left for step pin "); Serial.print(pin);
+      Serial.print(", using "); Serial.println(stepBackendName(fallback));
+    }
+  }
+  return stepper;
+}
+
+void initializeStations(FastAccelStepperEngine& engine) {
+  for (uint8_t i = 0; i < STATION_COUNT; i++) {
+    Station& station = stations[i];
+    const StationPins& pins = STATION_PIN_MAPS[i];
+    station.id = i;
+    station.pins = &pins;
+    memcpy(station.profiles, DEFAULT_MOTION_PROFILES, sizeof(station.profiles));
+    station.state = HOMING;
+    station.error = NO_ERROR_EC;
+    station.homingAxes = 0;
+    station.homedOnce = false;
+    setupTimer(station.stepTimer, "step");
+    setupTimer(station.cutHoming.timeout, "cut homing");
+    setupTimer(station.positionHoming.timeout, "position homing");
+
+    // Outputs: clamp valves start released
+    initializeClamps(station);
+
+    // Inputs: all switch and sensor pins are configured here, once
+    pinMode(pins.woodSensor, INPUT_PULLDOWN);
+    pinMode(pins.cutMotorHomingSwitch, INPUT_PULLDOWN);
+    pinMode(pins.positionMotorHomingSwitch, INPUT_PULLDOWN);
+    pinMode(pins.cycleSwitch, INPUT_PULLDOWN);
+
+    station.cutMotor = connectStepper(engine, pins.cutMotorPulse, CUT_MOTOR_STEP_BACKEND, &station.cutBackend);
+    if (station.cutMotor) {
+      station.cutMotor->setDirectionPin(pins.cutMotorDir);
+      // station.cutMotor->setAutoEnable(true); // Decide if you want auto-enable
+    }
+    station.positionMotor = connectStepper(engine, pins.positionMotorPulse, POSITION_MOTOR_STEP_BACKEND,
+                                           &station.positionBackend);
+    if (station.positionMotor) {
+      station.positionMotor->setDirectionPin(pins.positionMotorDir);
+    }
+  }
+}
+
+void faultStation(Station& station, ErrorCode error) {
+  if (station.cutMotor) {
+    station.cutMotor->forceStop();
+    traceEvent(station.id, TRACE_STOP, TRACE_AXIS_CUT, 0);
+  }
+  if (station.positionMotor) {
+    station.positionMotor->forceStop();
+    traceEvent(station.id, TRACE_STOP, TRACE_AXIS_POSITION, 0);
+  }
+  station.error = error;
+  transitionToState(station, ERROR);
+}
+
+bool areAxesStopped(const Station& station) {
+  if (station.cutMotor && station.cutMotor->isRunning()) return false;
+  if (station.positionMotor && station.positionMotor->isRunning()) return false;
+  return true;
+}
+
+const char* stepBackendName(uint8_t backend) {
+  switch (backend) {
+    case DRIVER_MCPWM_PCNT: return "MCPWM/PCNT";
+    case DRIVER_RMT: return "RMT";
+    default: return "auto";
+  }
+}
+
+uint8_t countStepBackendAxes(uint8_t backend) {
+  uint8_t count = 0;
+  for (const Station& station : stations) {
+    if (station.cutMotor && station.cutBackend == backend) count++;
+    if (station.positionMotor && station.positionBackend == backend) count++;
+  }
+  return count;
+}
+
+void setStationStep(Station& station, uint8_t step) {
+  station.step = step;
+  cancelTimer(station.stepTimer);
+  station.stepFlags = 0;
+}
@@ -0,0 +1,173 @@
+#include "Timers.h"
+#include "settings.h"
+#include <Arduino.h>
+
+//* ************************************************************************
+//* ***************************** TIMERS *********************************
+//* ************************************************************************
+// This file contains the definitions for the software timer service, a
+// hashed timer wheel with one slot per millisecond. A timer is kept in the
+// slot of its deadline (modulo the wheel size) on a doubly linked list, so
+// arming and cancelling are O(1). Each millisecond serviceTimers() walks only
+// that millisecond's slot; timers further away than one turn of the wheel are
+// skipped until their turn comes round. millis() has 1 ms steps, so a
+// deadline is one millisecond past the delay: a timer may fire up to 1 ms
+// late, but never early.
+
+static SoftTimer* wheel[TIMER_WHEEL_SLOTS];
+static uint32_t wheelTime = 0;      // Last millisecond whose slot has been serviced
+static bool wheelStarted = false;
+static uint8_t armedCount = 0;
+
+static SoftTimer* registeredTimers[MAX_TIMERS];
+static uint8_t registeredCount = 0;
+
+// Lateness over every timer that has fired since boot; early firings should stay at 0
+static uint32_t totalFired = 0;
+static uint64_t totalLatenessUs = 0;
+static uint32_t worstLatenessUs = 0;
+static uint32_t totalEarly = 0;
+static uint32_t worstEarlyUs = 0;
+
+static void unlinkTimer(SoftTimer& timer) {
+  if (timer.prev) timer.prev->next = timer.next;
+  else wheel[timer.deadline & (TIMER_WHEEL_SLOTS - 1)] = timer.next;
+  if (timer.next) timer.next->prev = timer.prev;
+  timer.next = timer.prev = NULL;
+  timer.armed = false;
+  armedCount--;
+}
+
+void setupTimer(SoftTimer& timer, const char* name, TimerCallback callback, void* arg) {
+  cancelTimer(timer);
+  timer.name = name;
+  timer.callback = callback;
+  timer.arg = arg;
+  for (uint8_t i = 0; i < registeredCount; i++) {
+    if (registeredTimers[i] == &timer) return;
+  }
+  if (registeredCount < MAX_TIMERS) {
+    registeredTimers[registeredCount++] = &timer;
+  } else {
+    Serial.print("WARNING: Timer table full, "); Serial.print(name); Serial.println(" is not listed.");
+  }
+}
+
+void armTimer(SoftTimer& timer, uint32_t delayMs) {
+  if (timer.armed) unlinkTimer(timer);
+  if (!wheelStarted) {
+    wheelTime = millis();
+    wheelStarted = true;
+  }
+
+  // A deadline in the past still has to land in a slot that will be walked
+  uint32_t deadline = millis() + delayMs + 1;
+  if ((int32_t)(deadline - wheelTime) <= 0) deadline = wheelTime + 1;
+
+  timer.deadline = deadline;
+  timer.armedAtUs = micros();
+  timer.delayMs = delayMs;
+  timer.fired = false;
+  timer.armed = true;
+
+  SoftTimer*& head = wheel[deadline & (TIMER_WHEEL_SLOTS - 1)];
+  timer.prev = NULL;
+  timer.next = head;
+  if (head) head->prev = &timer;
+  head = &timer;
+  armedCount++;
+}
+
+void armTimerWithin(SoftTimer& timer, uint32_t delayMs) {
+  if (timer.armed && (int32_t)(timer.deadline - (millis() + delayMs + 1)) <= 0) return;
+  armTimer(timer, delayMs);
+}
+
+void cancelTimer(SoftTimer& timer) {
+  if (timer.armed) unlinkTimer(timer);
+  timer.fired = false;
+}
+
+bool timerFired(const SoftTimer& timer) {
+  return timer.fired;
+}
+
+static void fireTimer(SoftTimer& timer) {
+  unlinkTimer(timer);
+  timer.fired = true;
+
+  uint32_t elapsedUs = micros() - timer.armedAtUs;
+  uint32_t delayUs = timer.delayMs * 1000UL;
+  uint32_t latenessUs = elapsedUs > delayUs ? elapsedUs - delayUs : 0;
+  if (elapsedUs < delayUs) {
+    uint32_t earlyUs = delayUs - elapsedUs;
+    if (earlyUs > timer.maxEarlyUs) timer.maxEarlyUs = earlyUs;
+    if (earlyUs > worstEarlyUs) worstEarlyUs = earlyUs;
+    totalEarly++;
+  }
+  timer.firedCount++;
+  timer.lastLatenessUs = latenessUs;
+  if (latenessUs > timer.maxLatenessUs) timer.maxLatenessUs = latenessUs;
+  totalFired++;
+  totalLatenessUs += latenessUs;
+  if (latenessUs > worstLatenessUs) worstLatenessUs = latenessUs;
+
+  // Last, so the callback may re-arm the timer
+  if (timer.callback) timer.callback(timer.arg);
+}
+
+void serviceTimers() {
+  if (!wheelStarted || armedCount == 0) {
+    wheelTime = millis();
+    wheelStarted = true;
+    return;
+  }
+
+  uint32_t now = millis();
+  // After a stall longer than one turn, one pass over every slot catches up
+  if (now - wheelTime > TIMER_WHEEL_SLOTS) wheelTime = now - TIMER_WHEEL_SLOTS;
+
+  // wheelTime moves with the walk, so a timer armed by a callback always
+  // lands in a slot that is still ahead
+  while (wheelTime != now) {
+    wheelTime++;
+    SoftTimer*& slot = wheel[wheelTime & (TIMER_WHEEL_SLOTS - 1)];
+    SoftTimer* timer = slot;
+    while (timer) {
+      if ((int32_t)(now - timer->deadline) >= 0) {
+        fireTimer(*timer);
+        timer = slot; // The callback may have changed the list; start the slot over
+      } else {
+        timer = timer->next;
+      }
+    }
+  }
+}
+
+void printTimers() {
+  Serial.println("==== TIMERS ====");
+  Serial.print("Armed: "); Serial.print(armedCount);
+  Serial.print(" of "); Serial.print(registeredCount); Serial.println(" registered");
+  Serial.print("Fired: "); Serial.print(totalFired);
+  Serial.print(", mean late (us): ");
+  Serial.print(totalFired ? (uint32_t)(totalLatenessUs / totalFired) : 0);
+  Serial.print(", worst late (us): "); Serial.print(worstLatenessUs);
+  Serial.print(", early: "); Serial.print(totalEarly);
+  Serial.print(" (worst "); Serial.print(worstEarlyUs); Serial.println(" us)");
+
+  uint32_t now = millis();
+  for (uint8_t i = 0; i < registeredCount; i++) {
+    const SoftTimer& timer = *registeredTimers[i];
+    Serial.print("  "); Serial.print(timer.name);
+    if (timer.armed) {
+      Serial.print(" armed, due in "); Serial.print((int32_t)(timer.deadline - now)); Serial.print(" ms");
+    } else {
+      Serial.print(" idle");
+    }
+    Serial.print(", fired "); Serial.print(timer.firedCount);
+    Serial.print(", last/max late (us): "); Serial.print(timer.lastLatenessUs);
+    Serial.print("/"); Serial.print(timer.maxLatenessUs);
+    if (timer.maxEarlyUs) { Serial.print(", max early (us): "); Serial.print(timer.maxEarlyUs); }
+    Serial.println();
+  }
+}
@@ -0,0 +1,299 @@
+#include "StepBench.h"
+#include "settings.h"
+#include "Station.h"
+#include "Motion.h"
+#include "Timers.h"
+#include "StateMachine.h"
+#include "Trace.h"
+#include <Arduino.h>
+#include <FastAccelStepper.h>
+#include <driver/pcnt.h>
+
+//* ************************************************************************
+//* *************************** STEP BENCHMARK ***************************
+//* ************************************************************************
+// This file contains the definitions for the step generation stress
+// benchmark. Each point of the sweep runs STEP_BENCH_REPEATS out-and-back
+// moves over the full travel of both axes at once. Per axis it compares:
+//   - the pulses counted on the loopback pin with the commanded steps
+//     (a difference is a missed or extra pulse), and
+//   - each move's duration with the ideal trapezoidal profile (an overrun
+//     means pulses came late, i.e. the backend could not keep the rate).
+// FastAccelStepper gives its n-th MCPWM/PCNT axis PCNT unit n, so the
+// loopback uses the two units after the last of those.
+
+static const uint8_t SPEED_COUNT = sizeof(STEP_BENCH_SPEEDS) / sizeof(STEP_BENCH_SPEEDS[0]);
+static const uint8_t ACCELERATION_COUNT = sizeof(STEP_BENCH_ACCELERATIONS) / sizeof(STEP_BENCH_ACCELERATIONS[0]);
+static const int16_t LOOPBACK_COUNT_LIMIT = 32000; // PCNT counts 0..limit-1, then wraps to 0
+
+struct BenchAxis {
+  const char* name;
+  TraceAxis traceAxis;
+  FastAccelStepper* stepper;
+  uint8_t backend;
+  pcnt_unit_t unit;
+  long travelSteps;       // Far end of the out-and-back move
+  int16_t lastCount;      // Last raw PCNT reading
+  uint32_t pulses;        // Loopback pulses in the current point
+  uint32_t commanded;     // Commanded steps in the current point
+  uint32_t moveStartUs;
+  uint32_t idealUs;       // Ideal duration of the current move
+  uint32_t worstOverrunUs;
+  bool moving;
+  bool rejected;          // Speed outside what the backend accepts
+  bool clean[SPEED_COUNT]; // No missed or late pulses at any acceleration of that speed
+};
+
+struct StepBenchmark {
+  Station* station;       // NULL when no benchmark is running
+  BenchAxis axes[2];
+  uint8_t speedIndex;
+  uint8_t accelerationIndex;
+  uint8_t repeat;
+  bool outbound;
+  SoftTimer serialLoad;
+  TaskHandle_t loadTask;
+  volatile bool loadStop;
+};
+
+static StepBenchmark bench;
+
+// Busy memory traffic for ~1 ms per tick, standing in for the rest of the
+// firmware's background work (there is no Wi-Fi on this machine)
+static void backgroundLoadTask(void* arg) {
+  static uint8_t source[1024];
+  static uint8_t sink[1024];
+  while (!bench.loadStop) {
+    unsigned long start = micros();
+    while (micros() - start < 1000) {
+      memcpy(sink, source, sizeof(sink));
+      source[0]++;
+    }
+    vTaskDelay(1);
+  }
+  bench.loadTask = NULL;
+  vTaskDelete(NULL);
+}
+
+// Serial load: a status line every STEP_BENCH_SERIAL_LOAD_MS while a point runs
+static void onSerialLoad(void* arg) {
+  Serial.print("BENCH: cut "); Serial.print(bench.axes[0].stepper->getCurrentPosition());
+  Serial.print(" pos "); Serial.print(bench.axes[1].stepper->getCurrentPosition());
+  Serial.print(" pulses "); Serial.print(bench.axes[0].pulses);
+  Serial.print("/"); Serial.println(bench.axes[1].pulses);
+  armTimer(bench.serialLoad, STEP_BENCH_SERIAL_LOAD_MS);
+}
+
+static void setupLoopback(BenchAxis& axis, uint8_t pin) {
+  pcnt_config_t config = {};
+  config.pulse_gpio_num = pin;
+  config.ctrl_gpio_num = PCNT_PIN_NOT_USED;
+  config.channel = PCNT_CHANNEL_0;
+  config.unit = axis.unit;
+  config.pos_mode = PCNT_COUNT_INC;   // Count rising edges only
+  config.neg_mode = PCNT_COUNT_DIS;
+  config.lctrl_mode = PCNT_MODE_KEEP;
+  config.hctrl_mode = PCNT_MODE_KEEP;
+  config.counter_h_lim = LOOPBACK_COUNT_LIMIT;
+  config.counter_l_lim = 0;
+  pcnt_unit_config(&config);
+  pcnt_filter_disable(axis.unit);     // The glitch filter would eat pulses at the top speeds
+  pcnt_counter_pause(axis.unit);
+  pcnt_counter_clear(axis.unit);
+  pcnt_counter_resume(axis.unit);
+  axis.lastCount = 0;
+}
+
+// Folds new loopback pulses into the axis total; called far more often than the counter wraps
+static void sampleLoopback(BenchAxis& axis) {
+  int16_t count = 0;
+  pcnt_get_counter_value(axis.unit, &count);
+  int32_t delta = count - axis.lastCount;
+  if (delta < 0) delta += LOOPBACK_COUNT_LIMIT;
+  axis.pulses += delta;
+  axis.lastCount = count;
+}
+
+static void startLeg() {
+  uint32_t speed = STEP_BENCH_SPEEDS[bench.speedIndex];
+  uint32_t acceleration = STEP_BENCH_ACCELERATIONS[bench.accelerationIndex];
+  AxisMoveLimits limits = {(float)speed, (float)acceleration};
+  uint32_t longestIdealUs = 0;
+
+  for (BenchAxis& axis : bench.axes) {
+    if (axis.rejected) continue;
+    long target = bench.outbound ? axis.travelSteps : 0;
+    long distance = labs(target - axis.stepper->getCurrentPosition());
+    axis.commanded += distance;
+    axis.idealUs = (uint32_t)(planCoordinatedMove(distance, 0, limits, limits).durationSec * 1e6f);
+    axis.moveStartUs = micros();
+    axis.stepper->moveTo(target);
+    traceEvent(bench.station->id, TRACE_MOVE_TO, axis.traceAxis, target);
+    axis.moving = true;
+    longestIdealUs = max(longestIdealUs, axis.idealUs);
+  }
+  armTimer(bench.station->stepTimer, moveTimeoutMs(longestIdealUs / 1e6f));
+}
+
+static void startPoint() {
+  uint32_t speed = STEP_BENCH_SPEEDS[bench.speedIndex];
+  uint32_t acceleration = STEP_BENCH_ACCELERATIONS[bench.accelerationIndex];
+  for (BenchAxis& axis : bench.axes) {
+    sampleLoopback(axis);
+    axis.pulses = 0;
+    axis.commanded = 0;
+    axis.worstOverrunUs = 0;
+    axis.moving = false;
+    axis.stepper->setLinearAcceleration(0); // Plain trapezoid, whatever profile ran last
+    axis.rejected = axis.stepper->setSpeedInHz(speed) < 0 ||
+                    axis.stepper->setAcceleration(acceleration) < 0;
+  }
+  bench.repeat = 0;
+  bench.outbound = true;
+  startLeg();
+}
+
+static void stopLoad() {
+  cancelTimer(bench.serialLoad);
+  bench.loadStop = true; // The task deletes itself within a tick
+}
+
+static void printAxisResult(const BenchAxis& axis, bool clean) {
+  Serial.print(axis.name); Serial.print(" ");
+  if (axis.rejected) {
+    Serial.print("speed rejected");
+    return;
+  }
+  Serial.print(axis.pulses); Serial.print("/"); Serial.print(axis.commanded);
+  Serial.print(" pulses, worst overrun "); Serial.print(axis.worstOverrunUs); Serial.print(" us ");
+  Serial.print(clean ? "ok" : (axis.pulses != axis.commanded ? "MISSED" : "LATE"));
+}
+
+static void finishPoint() {
+  uint32_t speed = STEP_BENCH_SPEEDS[bench.speedIndex];
+  Serial.print("BENCH RESULT: "); Serial.print(speed); Serial.print(" Hz, ");
+  Serial.print(STEP_BENCH_ACCELERATIONS[bench.accelerationIndex]); Serial.print(" Hz/s | ");
+  for (BenchAxis& axis : bench.axes) {
+    bool late = axis.worstOverrunUs > 0;
+    bool clean = !axis.rejected && !late && axis.pulses == axis.commanded;
+    if (!clean) axis.clean[bench.speedIndex] = false;
+    printAxisResult(axis, clean);
+    Serial.print(" | ");
+  }
+  Serial.println();
+}
+
+static void finishBenchmark() {
+  Station& station = *bench.station;
+  stopLoad();
+  Serial.println("==== STEP BENCHMARK SUMMARY ====");
+  for (const BenchAxis& axis : bench.axes) {
+    uint32_t best = 0;
+    for (uint8_t i = 0; i < SPEED_COUNT && axis.clean[i]; i++) best = STEP_BENCH_SPEEDS[i];
+    Serial.print(axis.name); Serial.print(" on "); Serial.print(stepBackendName(axis.backend));
+    Serial.print(": clean up to "); Serial.print(best); Serial.println(" Hz with both axes running");
+  }
+  bench.station = NULL;
+  Serial.println("BENCH: Done, re-homing (pulses may have been lost).");
+  transitionToState(station, HOMING);
+}
+
+void enterStepBenchmark(Station& station) {
+  if (bench.station) {
+    Serial.println("ERROR: A step benchmark is already running on another station.");
+    transitionToState(station, IDLE);
+    return;
+  }
+  uint8_t firstFreeUnit = countStepBackendAxes(DRIVER_MCPWM_PCNT);
+  if (!station.cutMotor || !station.positionMotor || firstFreeUnit + 2 > PCNT_UNIT_MAX) {
+    Serial.println("ERROR: Step benchmark needs both steppers and two free PCNT units.");
+    transitionToState(station, IDLE);
+    return;
+  }
+
+  Serial.println("BENCH: Starting step benchmark. Blade must be off; loopback jumpers fitted.");
+  bench.station = &station;
+  bench.axes[0] = BenchAxis();
+  bench.axes[0].name = "cut";
+  bench.axes[0].traceAxis = TRACE_AXIS_CUT;
+  bench.axes[0].stepper = station.cutMotor;
+  bench.axes[0].backend = station.cutBackend;
+  bench.axes[0].unit = (pcnt_unit_t)firstFreeUnit;
+  bench.axes[0].travelSteps = (long)(CUT_MOTOR_TRAVEL_DISTANCE * CUT_MOTOR_STEPS_PER_INCH);
+  bench.axes[1] = BenchAxis();
+  bench.axes[1].name = "position";
+  bench.axes[1].traceAxis = TRACE_AXIS_POSITION;
+  bench.axes[1].stepper = station.positionMotor;
+  bench.axes[1].backend = station.positionBackend;
+  bench.axes[1].unit = (pcnt_unit_t)(firstFreeUnit + 1);
+  bench.axes[1].travelSteps = (long)(POSITION_MOTOR_TRAVEL_DISTANCE * POSITION_MOTOR_STEPS_PER_INCH);
+  setupLoopback(bench.axes[0], STEP_LOOPBACK_CUT_PIN);
+  setupLoopback(bench.axes[1], STEP_LOOPBACK_POSITION_PIN);
+  for (BenchAxis& axis : bench.axes) {
+    for (bool& clean : axis.clean) clean = true;
+  }
+
+  bench.loadStop = false;
+  if (!bench.loadTask) {
+    xTaskCreatePinnedToCore(backgroundLoadTask, "bench load", 2048, NULL, 1, &bench.loadTask, tskNO_AFFINITY);
+  }
+  setupTimer(bench.serialLoad, "bench serial load", onSerialLoad);
+  armTimer(bench.serialLoad, STEP_BENCH_SERIAL_LOAD_MS);
+
+  bench.speedIndex = 0;
+  bench.accelerationIndex = 0;
+  startPoint();
+}
+
+void runStepBenchmark(Station& station) {
+  if (bench.station != &station) return;
+
+  bool anyMoving = false;
+  for (BenchAxis& axis : bench.axes) {
+    bool running = axis.stepper->isRunning(); // Before sampling, so a finished move's last pulse is counted
+    sampleLoopback(axis);
+    if (!axis.moving) continue;
+    if (running) {
+      anyMoving = true;
+      continue;
+    }
+    axis.moving = false;
+    uint32_t elapsedUs = micros() - axis.moveStartUs;
+    uint32_t allowedUs = (uint32_t)(axis.idealUs * (1.0f + STEP_BENCH_LATE_TOLERANCE)) + STEP_BENCH_LATE_SLACK_US;
+    if (elapsedUs > allowedUs && elapsedUs - allowedUs > axis.worstOverrunUs) {
+      axis.worstOverrunUs = elapsedUs - allowedUs;
+    }
+  }
+
+  if (anyMoving) {
+    if (timerFired(station.stepTimer)) {
+      Serial.println("ERROR: Step benchmark move timed out.");
+      stopLoad();
+      bench.station = NULL;
+      faultStation(station, bench.axes[0].moving ? CUT_MOTOR_TIMEOUT_EC : POSITION_MOTOR_TIMEOUT_EC);
+    }
+    return;
+  }
+
+  // Both axes have stopped: next leg, next repeat, next point or done
+  if (bench.outbound) {
+    bench.outbound = false;
+    startLeg();
+    return;
+  }
+  if (++bench.repeat < STEP_BENCH_REPEATS) {
+    bench.outbound = true;
+    startLeg();
+    return;
+  }
+  finishPoint();
+  if (++bench.accelerationIndex >= ACCELERATION_COUNT) {
+    bench.accelerationIndex = 0;
+    bench.speedIndex++;
+  }
+  if (bench.speedIndex >= SPEED_COUNT) {
+    finishBenchmark();
+  } else {
+    startPoint();
+  }
+}
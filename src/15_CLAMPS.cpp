@@ -0,0 +1,220 @@
+#include "Clamps.h"
+#include "settings.h"
+#include "Station.h"
+#include "Timers.h"
+#include <Arduino.h>
+
+//* ************************************************************************
+//* ****************************** CLAMPS ********************************
+//* ************************************************************************
+// This file contains the definitions for the peak-and-hold clamp valve driver.
+// A valve at its rated voltage pulls in slowly because the coil current
+// builds up against the spring and the spool. Where the valve supply is
+// above that rating (overdriveRatio > 1), the full-supply peak builds the
+// current faster and the shift is quicker and more repeatable. Once the
+// armature is in, a fraction of the rated current keeps it there: the hold
+// duty is that fraction divided by the overdrive ratio. On a valve that gates
+// on its feedback, the peak ends as soon as the sensor sees the clamp, so the
+// overdrive lasts no longer than needed. Feedback edges are polled once per
+// loop pass, which is well below the valve times being measured.
+
+static const uint32_t CLAMP_FULL_DUTY = (1UL << CLAMP_PWM_RESOLUTION_BITS) - 1;
+
+static uint32_t dutyFor(float fraction) {
+  if (fraction <= 0) return 0;
+  if (fraction >= 1) return CLAMP_FULL_DUTY;
+  return (uint32_t)(fraction * CLAMP_FULL_DUTY);
+}
+
+// Starts a latency measurement if the sensor is not already at the level it should reach
+static void startFeedback(ClampDriver& clamp, int targetLevel) {
+  clamp.switchedAtUs = micros();
+  clamp.awaitingFeedback = clamp.feedbackPin != CLAMP_NO_PIN && digitalRead(clamp.feedbackPin) != targetLevel;
+  clamp.feedbackLevel = targetLevel;
+  if (clamp.awaitingFeedback) {
+    armTimer(clamp.feedbackTimer, CLAMP_FEEDBACK_TIMEOUT_MS);
+  } else {
+    cancelTimer(clamp.feedbackTimer);
+  }
+}
+
+static bool gatesOnFeedback(const ClampDriver& clamp) {
+  return clamp.settings.gateOnFeedback && clamp.feedbackPin != CLAMP_NO_PIN;
+}
+
+static void startHold(ClampDriver& clamp) {
+  ledcWrite(clamp.channel, clamp.holdDuty);
+  clamp.phase = CLAMP_HOLD;
+}
+
+static void recordLatency(ClampLatency& latency, uint32_t us) {
+  if (latency.count == 0 || us < latency.minUs) latency.minUs = us;
+  if (us > latency.maxUs) latency.maxUs = us;
+  latency.totalUs += us;
+  latency.count++;
+}
+
+static void onPhaseTimer(void* arg) {
+  ClampDriver& clamp = *(ClampDriver*)arg;
+  if (clamp.phase == CLAMP_PEAK) {
+    startHold(clamp);
+  } else if (clamp.phase == CLAMP_DUMP) {
+    digitalWrite(clamp.dumpPin, LOW);
+    clamp.phase = CLAMP_OFF;
+  }
+}
+
+static void setupClamp(Station& station, ClampValve valve, const char* name, uint8_t pin, uint8_t dumpPin,
+                       uint8_t feedbackPin) {
+  ClampDriver& clamp = station.clamps[valve];
+  clamp.name = name;
+  clamp.settings = CLAMP_DRIVE_SETTINGS[valve];
+  clamp.pin = pin;
+  clamp.channel = station.id * CLAMP_VALVE_COUNT + valve;
+  clamp.dumpPin = dumpPin;
+  clamp.feedbackPin = feedbackPin;
+  clamp.phase = CLAMP_OFF;
+  clamp.awaitingFeedback = false;
+  clamp.holdDuty = dutyFor(clamp.settings.holdFraction / clamp.settings.overdriveRatio);
+  setupTimer(clamp.phaseTimer, name, onPhaseTimer, &clamp);
+  setupTimer(clamp.feedbackTimer, "clamp feedback");
+
+  ledcSetup(clamp.channel, CLAMP_PWM_FREQUENCY_HZ, CLAMP_PWM_RESOLUTION_BITS);
+  ledcAttachPin(pin, clamp.channel);
+  ledcWrite(clamp.channel, 0);
+  if (dumpPin != CLAMP_NO_PIN) {
+    pinMode(dumpPin, OUTPUT);
+    digitalWrite(dumpPin, LOW);
+  }
+  if (feedbackPin != CLAMP_NO_PIN) {
+    pinMode(feedbackPin, INPUT_PULLDOWN);
+  }
+}
+
+void initializeClamps(Station& station) {
+  const StationPins& pins = *station.pins;
+  setupClamp(station, CLAMP_POSITION, "position clamp", pins.positionClamp, pins.positionClampDump,
+             pins.positionClampFeedback);
+  setupClamp(station, CLAMP_SECURE_WOOD, "secure clamp", pins.secureWoodClamp, pins.secureWoodClampDump,
+             pins.secureWoodClampFeedback);
+  resetClampLatencies(station);
+}
+
+void engageClamp(Station& station, ClampValve valve) {
+  ClampDriver& clamp = station.clamps[valve];
+  if (clamp.phase == CLAMP_PEAK || clamp.phase == CLAMP_HOLD) return;
+
+  if (clamp.phase == CLAMP_DUMP) digitalWrite(clamp.dumpPin, LOW); // Never drive both legs
+  ledcWrite(clamp.channel, CLAMP_FULL_DUTY);
+  startFeedback(clamp, CLAMP_FEEDBACK_ENGAGED_LEVEL);
+  if (clamp.settings.peakMs > 0) {
+    clamp.phase = CLAMP_PEAK;
+    armTimer(clamp.phaseTimer, clamp.settings.peakMs);
+  } else {
+    cancelTimer(clamp.phaseTimer);
+    startHold(clamp);
+  }
+}
+
+void releaseClamp(Station& station, ClampValve valve) {
+  ClampDriver& clamp = station.clamps[valve];
+  if (clamp.phase == CLAMP_OFF || clamp.phase == CLAMP_DUMP) return;
+
+  ledcWrite(clamp.channel, 0);
+  startFeedback(clamp, !CLAMP_FEEDBACK_ENGAGED_LEVEL);
+  if (clamp.dumpPin != CLAMP_NO_PIN && clamp.settings.dumpMs > 0) {
+    digitalWrite(clamp.dumpPin, HIGH);
+    clamp.phase = CLAMP_DUMP;
+    armTimer(clamp.phaseTimer, clamp.settings.dumpMs);
+  } else {
+    cancelTimer(clamp.phaseTimer);
+    clamp.phase = CLAMP_OFF;
+  }
+}
+
+// A clamp that gates on its sensor counts as engaged on the edge; any other,
+// or one whose edge is overdue, when the peak pulse has run its full time
+bool isClampEngaged(const Station& station, ClampValve valve) {
+  const ClampDriver& clamp = station.clamps[valve];
+  if (clamp.phase != CLAMP_HOLD) return false;
+  return !gatesOnFeedback(clamp) || !clamp.awaitingFeedback;
+}
+
+void serviceClamps() {
+  for (Station& station : stations) {
+    for (ClampDriver& clamp : station.clamps) {
+      if (!clamp.awaitingFeedback) continue;
+      bool engaging = clamp.feedbackLevel == CLAMP_FEEDBACK_ENGAGED_LEVEL;
+      ClampLatency& latency = engaging ? clamp.engageLatency : clamp.releaseLatency;
+      if (digitalRead(clamp.feedbackPin) == clamp.feedbackLevel) {
+        recordLatency(latency, micros() - clamp.switchedAtUs);
+        clamp.awaitingFeedback = false;
+        cancelTimer(clamp.feedbackTimer);
+        if (engaging && clamp.phase == CLAMP_PEAK && gatesOnFeedback(clamp)) { // Pulled in: stop overdriving
+          cancelTimer(clamp.phaseTimer);
+          startHold(clamp);
+        }
+      } else if (timerFired(clamp.feedbackTimer)) {
+        latency.missed++;
+        clamp.awaitingFeedback = false;
+        if ((latency.missed - 1) % CLAMP_FEEDBACK_WARN_EVERY == 0) {
+          Serial.print("WARNING: [S"); Serial.print(station.id); Serial.print("] No feedback from ");
+          Serial.print(clamp.name); Serial.print(engaging ? " engaging (" : " releasing (");
+          Serial.print(latency.missed); Serial.println(" missed, see 'clamps').");
+        }
+      }
+    }
+  }
+}
+
+void resetClampLatencies(Station& station) {
+  for (ClampDriver& clamp : station.clamps) {
+    clamp.engageLatency = ClampLatency();
+    clamp.releaseLatency = ClampLatency();
+  }
+}
+
+static const char* clampPhaseName(ClampPhase phase) {
+  switch (phase) {
+    case CLAMP_PEAK: return "pulling in";
+    case CLAMP_HOLD: return "engaged";
+    case CLAMP_DUMP: return "dumping";
+    default: return "released";
+  }
+}
+
+static void printLatency(const char* label, const ClampLatency& latency) {
+  Serial.print("  "); Serial.print(label);
+  Serial.print(" | count "); Serial.print(latency.count);
+  if (latency.count) {
+    Serial.print(", mean/min/max ms ");
+    Serial.print(latency.totalUs / latency.count / 1000.0f, 1); Serial.print("/");
+    Serial.print(latency.minUs / 1000.0f, 1); Serial.print("/");
+    Serial.print(latency.maxUs / 1000.0f, 1);
+  }
+  Serial.print(", missed "); Serial.println(latency.missed);
+}
+
+void printClamps(Station& station) {
+  Serial.print("==== CLAMPS (station "); Serial.print(station.id); Serial.println(") ====");
+  for (const ClampDriver& clamp : station.clamps) {
+    Serial.print(clamp.name);
+    Serial.print(": pin "); Serial.print(clamp.pin);
+    Serial.print(", overdrive "); Serial.print(clamp.settings.overdriveRatio, 1);
+    Serial.print("x, peak up to "); Serial.print(clamp.settings.peakMs); Serial.print(" ms");
+    Serial.print(", hold "); Serial.print(clamp.holdDuty * 100.0f / CLAMP_FULL_DUTY, 0); Serial.print("% duty");
+    if (clamp.dumpPin != CLAMP_NO_PIN) {
+      Serial.print(", dump pin "); Serial.print(clamp.dumpPin);
+      Serial.print(" for "); Serial.print(clamp.settings.dumpMs); Serial.print(" ms");
+    }
+    Serial.print(", "); Serial.println(clampPhaseName(clamp.phase));
+    if (clamp.feedbackPin == CLAMP_NO_PIN) {
+      Serial.println("  no feedback sensor");
+    } else {
+      Serial.print("  feedback pin "); Serial.print(clamp.feedbackPin);
+      Serial.println(gatesOnFeedback(clamp) ? ", gates engaged" : ", timed only");
+      printLatency("engage ", clamp.engageLatency);
+      printLatency("release", clamp.releaseLatency);
+    }
+  }
+}
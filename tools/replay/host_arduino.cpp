@@ -0,0 +1,182 @@
+// Virtual-time implementation of the host shims (Arduino core, Serial,
+// FastAccelStepper, Preferences) used by the replay harness.
+#include "host_arduino.h"
+
+#include <Arduino.h>
+#include <FastAccelStepper.h>
+#include <Preferences.h>
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+HardwareSerial Serial;
+
+namespace {
+
+const uint64_t QUANTUM_US = 50;       // Integration step for motion and input delivery
+const uint64_t DELAY0_US = 20;        // Cost charged for delay(0)/yield() so polling loops make progress
+
+struct ScheduledInput {
+  uint64_t timeUs;
+  uint8_t pin;
+  int level;
+  bool operator>(const ScheduledInput& o) const { return timeUs > o.timeUs; }
+};
+
+struct Interrupt {
+  void (*fn)(void*) = nullptr;
+  void* arg = nullptr;
+};
+
+uint64_t nowUs = 0;
+uint64_t endUs = UINT64_MAX;
+bool verbose = false;
+int pinLevels[64];
+Interrupt interrupts[64];
+std::priority_queue<ScheduledInput, std::vector<ScheduledInput>, std::greater<ScheduledInput>> inputs;
+std::vector<std::unique_ptr<FastAccelStepper>> steppers;
+std::map<std::string, std::vector<uint8_t>> nvs;
+
+void deliverInputs() {
+  while (!inputs.empty() && inputs.top().timeUs <= nowUs) {
+    ScheduledInput in = inputs.top();
+    inputs.pop();
+    hostSetPin(in.pin, in.level);
+  }
+}
+
+}  // namespace
+
+// --- Harness control ---
+void hostSetVerbose(bool on) { verbose = on; }
+void hostSetEndTime(uint64_t us) { endUs = us; }
+void hostScheduleInput(uint64_t timeUs, uint8_t pin, int level) { inputs.push({timeUs, pin, level}); }
+uint64_t hostNowUs() { return nowUs; }
+
+void hostSetPin(uint8_t pin, int level) {
+  if (pin >= 64 || pinLevels[pin] == level) return;
+  pinLevels[pin] = level;
+  if (interrupts[pin].fn) interrupts[pin].fn(interrupts[pin].arg);
+}
+
+void hostAdvance(uint64_t us) {
+  uint64_t until = nowUs + us;
+  while (nowUs < until) {
+    uint64_t dt = until - nowUs < QUANTUM_US ? until - nowUs : QUANTUM_US;
+    nowUs += dt;
+    for (auto& s : steppers) s->hostStep(dt / 1e6);
+    deliverInputs();
+    if (nowUs >= endUs) throw ReplayFinished();
+  }
+}
+
+// --- Arduino core ---
+unsigned long millis() { return (unsigned long)(nowUs / 1000); }
+unsigned long micros() { return (uint32_t)nowUs; }
+void delay(unsigned long ms) { hostAdvance(ms ? ms * 1000ULL : DELAY0_US); }
+void delayMicroseconds(unsigned int us) { hostAdvance(us); }
+void yield() { hostAdvance(DELAY0_US); }
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin < 64) pinLevels[pin] = val;
+}
+int digitalRead(uint8_t pin) { return pin < 64 ? pinLevels[pin] : LOW; }
+static uint8_t ledcPins[16];
+double ledcSetup(uint8_t, double freq, uint8_t) { return freq; }
+void ledcAttachPin(uint8_t pin, uint8_t channel) {
+  if (channel < 16) ledcPins[channel] = pin;
+}
+void ledcWrite(uint8_t channel, uint32_t duty) {
+  if (channel < 16) digitalWrite(ledcPins[channel], duty ? HIGH : LOW);
+}
+void attachInterruptArg(uint8_t pin, void (*fn)(void*), void* arg, int) {
+  if (pin < 64) interrupts[pin] = {fn, arg};
+}
+void detachInterrupt(uint8_t pin) {
+  if (pin < 64) interrupts[pin] = {};
+}
+
+// --- Serial ---
+int HardwareSerial::available() { return 0; }
+int HardwareSerial::read() { return -1; }
+size_t HardwareSerial::print(const char* s) {
+  if (verbose) fputs(s, stderr);
+  return strlen(s);
+}
+size_t HardwareSerial::print(char c) {
+  if (verbose) fputc(c, stderr);
+  return 1;
+}
+size_t HardwareSerial::print(long v, int) {
+  char buf[24];
+  snprintf(buf, sizeof(buf), "%ld", v);
+  return print(buf);
+}
+size_t HardwareSerial::print(unsigned long v, int) {
+  char buf[24];
+  snprintf(buf, sizeof(buf), "%lu", v);
+  return print(buf);
+}
+size_t HardwareSerial::print(double v, int digits) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.*f", digits, v);
+  return print(buf);
+}
+
+// --- FastAccelStepper ---
+FastAccelStepper* FastAccelStepperEngine::stepperConnectToPin(uint8_t, uint8_t) {
+  steppers.emplace_back(new FastAccelStepper());
+  return steppers.back().get();
+}
+
+void FastAccelStepper::stopMove() {
+  if (!running_) return;
+  double a = accel_ > 0 ? accel_ : 1e9;
+  double stopDistance = velocity_ * velocity_ / (2 * a);
+  target_ = (int64_t)llround(position_ + (velocity_ >= 0 ? stopDistance : -stopDistance));
+}
+
+void FastAccelStepper::hostStep(double dt) {
+  if (!running_) return;
+  double a = accel_ > 0 ? accel_ : 1e9;
+  double remaining = (double)target_ - position_;
+  double dir = remaining >= 0 ? 1 : -1;
+  double stopDistance = velocity_ * velocity_ / (2 * a);
+
+  if (velocity_ * dir < 0 || fabs(remaining) <= stopDistance) {
+    // Brake (also when heading away from the target)
+    double dv = a * dt;
+    if (fabs(velocity_) <= dv) velocity_ = 0;
+    else velocity_ -= (velocity_ > 0 ? dv : -dv);
+  } else {
+    velocity_ += dir * a * dt;
+    if (fabs(velocity_) > maxSpeed_) velocity_ = dir * maxSpeed_;
+  }
+  position_ += velocity_ * dt;
+
+  double left = (double)target_ - position_;
+  if (left * dir <= 0 || (fabs(left) < 0.5 && fabs(velocity_) <= 2 * a * dt)) {
+    position_ = (double)target_;
+    velocity_ = 0;
+    running_ = false;
+  }
+}
+
+// --- Preferences ---
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+  auto it = nvs.find(key);
+  if (it == nvs.end() || it->second.size() > maxLen) return 0;
+  memcpy(buf, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+  const uint8_t* p = static_cast<const uint8_t*>(value);
+  nvs[key].assign(p, p + len);
+  return len;
+}
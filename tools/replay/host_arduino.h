@@ -0,0 +1,9 @@
+#pragma once
+// Harness-side controls for the virtual-time host shims.
+#include <stdint.h>
+
+struct ReplayFinished {};  // Thrown from hostAdvance() when the end time is reached
+
+void hostSetVerbose(bool on);
+void hostSetEndTime(uint64_t us);
+void hostScheduleInput(uint64_t timeUs, uint8_t pin, int level);
@@ -0,0 +1,268 @@
+// Deterministic replay benchmark: runs the unmodified firmware sources
+// against a trace captured on the machine ('trace dump' over Serial) in virtual time
+// and reports per-phase timing for the recording and for the replay.
+//
+//   make && ./replay [-v] [--tail MS] [--loop-us US] capture.log
+#include "host_arduino.h"
+
+#include <Arduino.h>
+#include <FastAccelStepper.h>
+#include "StateMachine.h"
+#include "Station.h"
+#include "Trace.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+void setup();
+void loop();
+
+namespace {
+
+struct Event {
+  uint64_t timeUs;   // Since capture start, on the recording device or in virtual time
+  char type;
+  int id;
+  long value;
+  int station;
+};
+
+struct Capture {
+  std::vector<Event> events;
+  int atBoot = -1;           // 1 = started from setup(), 0 = 'trace start', -1 = not recorded (older captures)
+  unsigned long dropped = 0;
+};
+
+struct PhaseStats {
+  unsigned count = 0;
+  double totalMs = 0, minMs = 0, maxMs = 0;
+  void add(double ms) {
+    if (count == 0 || ms < minMs) minMs = ms;
+    if (count == 0 || ms > maxMs) maxMs = ms;
+    totalMs += ms;
+    count++;
+  }
+  double meanMs() const { return count ? totalMs / count : 0; }
+};
+
+typedef std::map<std::string, PhaseStats> PhaseTable;
+
+// Trace lines start with "T ", possibly after a terminal program's timestamp prefix
+size_t findTraceLine(const std::string& line) {
+  size_t at = line.find("T ");
+  while (at != std::string::npos && at > 0 && line[at - 1] != ' ') at = line.find("T ", at + 1);
+  return at;
+}
+
+bool loadTrace(const char* path, Capture& capture) {
+  std::ifstream in(path);
+  if (!in) return false;
+  std::string line;
+  uint64_t time = 0;
+  bool inTrace = false;
+  while (std::getline(in, line)) {
+    size_t at = findTraceLine(line);
+    if (at == std::string::npos) continue;  // Ordinary log output
+    std::istringstream ss(line.substr(at + 2));
+    std::string first;
+    ss >> first;
+    if (first == "BEGIN") {
+      unsigned long count, start;
+      capture.atBoot = -1;
+      ss >> count >> capture.dropped >> start >> capture.atBoot;
+      capture.events.clear();
+      time = 0;  // Times are kept relative to the capture start
+      inTrace = true;
+    } else if (first == "END") {
+      ss >> capture.dropped;  // Includes events dropped while the dump was sent
+      inTrace = false;
+    } else if (inTrace && isdigit((unsigned char)first[0])) {
+      Event e;
+      time += strtoul(first.c_str(), nullptr, 10);
+      e.timeUs = time;
+      e.station = 0;  // Field is absent in single-station captures
+      ss >> e.type >> e.id >> e.value >> e.station;
+      capture.events.push_back(e);
+    }
+  }
+  if (capture.dropped) fprintf(stderr, "warning: %lu events were dropped during capture\n", capture.dropped);
+  return !capture.events.empty();
+}
+
+// Older captures do not say how they were started; one that opens with every
+// station homing is taken as a boot capture
+bool startedAtBoot(const Capture& capture) {
+  if (capture.atBoot >= 0) return capture.atBoot == 1;
+  for (const Event& e : capture.events) {
+    if (e.type == TRACE_STATE) return e.id == HOMING;  // First state in the snapshot
+  }
+  return true;
+}
+
+// A capture started with 'trace start' begins wherever the stations were.
+// The harness can resume a station that was IDLE (or in ERROR) at its
+// recorded axis positions; one caught mid-cycle cannot be reproduced.
+bool seedStations(const std::vector<Event>& events) {
+  std::map<int, long> cutPositions, positionPositions;
+  std::map<int, MachineState> states;
+  for (const Event& e : events) {
+    // The snapshot taken at capture start is the leading run of L, A and X events
+    bool snapshot = e.type == TRACE_INPUT_LEVEL || e.type == TRACE_START_POSITION ||
+                    (e.type == TRACE_STATE && !states.count(e.station));
+    if (!snapshot) break;
+    if (e.type == TRACE_START_POSITION) {
+      (e.id == TRACE_AXIS_CUT ? cutPositions : positionPositions)[e.station] = e.value;
+    } else if (e.type == TRACE_STATE) {
+      states[e.station] = (MachineState)e.id;
+    }
+  }
+  for (const auto& kv : states) {
+    if (kv.second != IDLE && kv.second != ERROR) {
+      fprintf(stderr, "capture started while station %d was in %s; start captures at boot or while "
+              "every station is IDLE\n", kv.first, stateToString(kv.second));
+      return false;
+    }
+    if (kv.first >= STATION_COUNT) {
+      fprintf(stderr, "capture has station %d, firmware is built for %u\n", kv.first, STATION_COUNT);
+      return false;
+    }
+  }
+  for (const auto& kv : states) {
+    Station& station = stations[kv.first];
+    cancelTimer(station.cutHoming.timeout);
+    cancelTimer(station.positionHoming.timeout);
+    if (station.cutMotor) station.cutMotor->forceStopAndNewPosition(cutPositions[kv.first]);
+    if (station.positionMotor) station.positionMotor->forceStopAndNewPosition(positionPositions[kv.first]);
+    station.homedOnce = kv.second == IDLE;
+    transitionToState(station, kv.second);
+  }
+  return true;
+}
+
+// Phases of stations other than 0 are reported as NAME#station
+std::string phaseName(const char* name, int station) {
+  return station ? std::string(name) + "#" + std::to_string(station) : std::string(name);
+}
+
+// A phase lasts from one state entry to the next; a cycle from CUTTING to the next IDLE
+PhaseTable phaseTimings(const std::vector<Event>& events) {
+  PhaseTable table;
+  std::map<int, const Event*> entered;
+  std::map<int, uint64_t> cycleStart;
+  for (const Event& e : events) {
+    if (e.type != TRACE_STATE) continue;
+    const Event*& last = entered[e.station];
+    uint64_t& start = cycleStart[e.station];
+    if (last) {
+      table[phaseName(stateToString((MachineState)last->id), e.station)].add((e.timeUs - last->timeUs) / 1000.0);
+    }
+    if (e.id == CUTTING && !start) start = e.timeUs;
+    if (e.id == IDLE && start) {
+      table[phaseName("(full cycle)", e.station)].add((e.timeUs - start) / 1000.0);
+      start = 0;
+    }
+    last = &e;
+  }
+  return table;
+}
+
+std::map<char, unsigned> motionCounts(const std::vector<Event>& events) {
+  std::map<char, unsigned> counts;
+  for (const Event& e : events) {
+    if (e.type == TRACE_MOVE_TO || e.type == TRACE_MOVE || e.type == TRACE_STOP || e.type == TRACE_SET_POSITION) {
+      counts[e.type]++;
+    }
+  }
+  return counts;
+}
+
+void printReport(const PhaseTable& recorded, const PhaseTable& replayed) {
+  printf("%-14s %28s   %28s   %10s\n", "phase", "recorded n/mean/min/max ms", "replay n/mean/min/max ms", "delta mean");
+  PhaseTable names = recorded;
+  names.insert(replayed.begin(), replayed.end());
+  for (const auto& kv : names) {
+    PhaseStats r, p;
+    if (recorded.count(kv.first)) r = recorded.at(kv.first);
+    if (replayed.count(kv.first)) p = replayed.at(kv.first);
+    printf("%-14s %4u %7.1f %7.1f %7.1f   %4u %7.1f %7.1f %7.1f   %+10.1f\n", kv.first.c_str(),
+           r.count, r.meanMs(), r.minMs, r.maxMs, p.count, p.meanMs(), p.minMs, p.maxMs,
+           p.meanMs() - r.meanMs());
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* path = nullptr;
+  uint64_t tailUs = 2000000;
+  uint64_t loopUs = 20;  // Virtual cost of one loop() iteration
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-v")) hostSetVerbose(true);
+    else if (!strcmp(argv[i], "--tail") && i + 1 < argc) tailUs = strtoull(argv[++i], nullptr, 10) * 1000;
+    else if (!strcmp(argv[i], "--loop-us") && i + 1 < argc) loopUs = strtoull(argv[++i], nullptr, 10);
+    else path = argv[i];
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s [-v] [--tail MS] [--loop-us US] capture.log\n", argv[0]);
+    return 2;
+  }
+
+  Capture capture;
+  if (!loadTrace(path, capture)) {
+    fprintf(stderr, "no trace found in %s\n", path);
+    return 1;
+  }
+  const std::vector<Event>& recorded = capture.events;
+
+  // Input levels at capture start are in place before setup() reads them
+  for (const Event& e : recorded) {
+    if (e.type == TRACE_INPUT_LEVEL) hostSetPin(e.id, e.value);
+  }
+
+  uint64_t captureStartUs = 0;
+  try {
+    setup();
+    if (!startedAtBoot(capture)) {
+      if (!seedStations(recorded)) return 1;
+      startTraceCapture();  // Replay events start from the seeded stations, as recorded
+    }
+
+    // Reproduce the input edges at their recorded times after the capture start
+    captureStartUs = hostNowUs();
+    for (const Event& e : recorded) {
+      if (e.type == TRACE_INPUT_EDGE) hostScheduleInput(captureStartUs + e.timeUs, e.id, e.value);
+    }
+    hostSetEndTime(captureStartUs + recorded.back().timeUs + tailUs);
+
+    for (;;) {
+      loop();
+      hostAdvance(loopUs);
+    }
+  } catch (const ReplayFinished&) {
+  }
+
+  size_t count = 0;
+  const TraceEvent* raw = getTraceEvents(&count);
+  std::vector<Event> replayed;
+  for (size_t i = 0; i < count; i++) {
+    // micros() is 32-bit; the host run is far shorter than its wrap period
+    uint64_t timeUs = raw[i].timeUs - (uint32_t)captureStartUs;
+    replayed.push_back({timeUs, (char)raw[i].type, raw[i].id, raw[i].value, raw[i].station});
+  }
+
+  printf("trace: %zu recorded events, %zu replayed events, %.3f s virtual time\n", recorded.size(),
+         replayed.size(), hostNowUs() / 1e6);
+  printReport(phaseTimings(recorded), phaseTimings(replayed));
+
+  std::map<char, unsigned> rc = motionCounts(recorded), pc = motionCounts(replayed);
+  printf("motion commands (recorded/replay):");
+  for (char t : {'M', 'R', 'S', 'P'}) printf(" %c %u/%u", t, rc[t], pc[t]);
+  printf("\n");
+  return 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+// Host replacement for the subset of the Arduino-ESP32 core used by the
+// firmware. Time is virtual: it only advances through delay(), the replay
+// loop, and hostAdvance().
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+using std::min;
+using std::max;
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+#define CHANGE 0x03
+#define RISING 0x01
+#define FALLING 0x02
+
+#define IRAM_ATTR
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+#define digitalPinToInterrupt(p) (p)
+
+// FreeRTOS subset
+typedef void* TaskHandle_t;
+#define tskNO_AFFINITY 0x7FFFFFFF
+inline int xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*, unsigned, TaskHandle_t* handle, int) {
+  if (handle) *handle = nullptr;  // Background tasks do not run on the host
+  return 1;
+}
+inline void vTaskDelete(TaskHandle_t) {}
+inline void vTaskDelay(uint32_t) {}
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+// LEDC: the duty is not modelled, a channel only drives its pin HIGH when non-zero
+double ledcSetup(uint8_t channel, double freq, uint8_t resolutionBits);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcWrite(uint8_t channel, uint32_t duty);
+void attachInterruptArg(uint8_t pin, void (*fn)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+class HardwareSerial {
+ public:
+  void begin(unsigned long) {}
+  int available();
+  int read();
+  int availableForWrite() { return 4096; }  // Output is never held up on the host
+  operator bool() const { return true; }
+
+  size_t print(const char* s);
+  size_t print(char c);
+  size_t print(int v, int base = 10) { return print((long)v, base); }
+  size_t print(unsigned int v, int base = 10) { return print((unsigned long)v, base); }
+  size_t print(long v, int base = 10);
+  size_t print(unsigned long v, int base = 10);
+  size_t print(unsigned char v, int base = 10) { return print((unsigned long)v, base); }
+  size_t print(double v, int digits = 2);
+
+  template <typename T>
+  size_t println(T v) { size_t n = print(v); return n + print("\n"); }
+  template <typename T>
+  size_t println(T v, int fmt) { size_t n = print(v, fmt); return n + print("\n"); }
+  size_t println() { return print("\n"); }
+};
+
+extern HardwareSerial Serial;
+
+// --- Harness hooks (implemented in host_arduino.cpp) ---
+void hostAdvance(uint64_t us);
+uint64_t hostNowUs();
+void hostSetPin(uint8_t pin, int level);   // Drives an input and fires its interrupt
@@ -0,0 +1,41 @@
+#pragma once
+// Host replacement for Bounce2 using the library's default stable-interval
+// debounce algorithm.
+#include <Arduino.h>
+
+class Bounce {
+ public:
+  void attach(int pin, int mode) {
+    pinMode(pin, mode);
+    attach(pin);
+  }
+  void attach(int pin) {
+    pin_ = pin;
+    state_ = unstable_ = digitalRead(pin);
+    previousMillis_ = millis();
+  }
+  void interval(uint16_t ms) { interval_ = ms; }
+  bool update() {
+    int raw = digitalRead(pin_);
+    changed_ = false;
+    if (raw != unstable_) {
+      unstable_ = raw;
+      previousMillis_ = millis();
+    } else if (raw != state_ && millis() - previousMillis_ >= interval_) {
+      state_ = raw;
+      changed_ = true;
+    }
+    return changed_;
+  }
+  int read() const { return state_; }
+  bool rose() const { return changed_ && state_ == HIGH; }
+  bool fell() const { return changed_ && state_ == LOW; }
+
+ private:
+  int pin_ = 0;
+  int state_ = 0;
+  int unstable_ = 0;
+  bool changed_ = false;
+  uint16_t interval_ = 10;
+  unsigned long previousMillis_ = 0;
+};
@@ -0,0 +1,43 @@
+#pragma once
+// Host replacement for FastAccelStepper: each stepper follows a trapezoidal
+// velocity profile integrated in virtual time.
+#include <Arduino.h>
+
+#define DRIVER_MCPWM_PCNT 0
+#define DRIVER_RMT 1
+#define DRIVER_DONT_CARE 2
+
+class FastAccelStepper {
+ public:
+  void setDirectionPin(uint8_t pin, bool = true, uint16_t = 0) { dirPin_ = pin; }
+  int8_t setSpeedInHz(uint32_t hz) { maxSpeed_ = hz; return 0; }
+  int8_t setSpeedInMilliHz(uint32_t milliHz) { maxSpeed_ = milliHz / 1000.0; return 0; }
+  int8_t setAcceleration(int32_t accel) { accel_ = accel; return 0; }
+  void setLinearAcceleration(uint32_t) {}  // The S-curve start is not modelled
+  int8_t moveTo(int32_t position, bool = false) { target_ = position; running_ = true; return 0; }
+  int8_t move(int32_t steps, bool = false) { target_ = (int64_t)target_ + steps; running_ = true; return 0; }
+  void stopMove();
+  void forceStop() { running_ = false; velocity_ = 0; target_ = (int64_t)llround(position_); }
+  void forceStopAndNewPosition(int32_t position) { running_ = false; velocity_ = 0; position_ = target_ = position; }
+  void setCurrentPosition(int32_t position) { position_ = target_ = position; }
+  int32_t getCurrentPosition() const { return (int32_t)llround(position_); }
+  bool isRunning() const { return running_; }
+
+  // Integrates the motion over dt seconds (called by the harness)
+  void hostStep(double dt);
+
+ private:
+  uint8_t dirPin_ = 0;
+  double maxSpeed_ = 0;
+  double accel_ = 0;
+  double position_ = 0;
+  double velocity_ = 0;     // Signed, steps/s
+  int64_t target_ = 0;
+  bool running_ = false;
+};
+
+class FastAccelStepperEngine {
+ public:
+  void init() {}
+  FastAccelStepper* stepperConnectToPin(uint8_t stepPin, uint8_t driverType = DRIVER_DONT_CARE);
+};
@@ -0,0 +1,11 @@
+#pragma once
+// Host replacement for the ESP32 Preferences (NVS) library, kept in memory.
+#include <Arduino.h>
+
+class Preferences {
+ public:
+  bool begin(const char*, bool = false) { return true; }
+  void end() {}
+  size_t getBytes(const char* key, void* buf, size_t maxLen);
+  size_t putBytes(const char* key, const void* value, size_t len);
+};
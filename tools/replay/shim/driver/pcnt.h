@@ -0,0 +1,33 @@
+#pragma once
+// Host replacement for the ESP-IDF legacy pulse counter driver. There is no
+// step loopback on the host, so counters stay at zero.
+#include <stdint.h>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define PCNT_PIN_NOT_USED (-1)
+
+typedef enum { PCNT_UNIT_0, PCNT_UNIT_1, PCNT_UNIT_2, PCNT_UNIT_3, PCNT_UNIT_MAX } pcnt_unit_t;
+typedef enum { PCNT_CHANNEL_0, PCNT_CHANNEL_1 } pcnt_channel_t;
+typedef enum { PCNT_COUNT_DIS, PCNT_COUNT_INC, PCNT_COUNT_DEC } pcnt_count_mode_t;
+typedef enum { PCNT_MODE_KEEP, PCNT_MODE_REVERSE, PCNT_MODE_DISABLE } pcnt_ctrl_mode_t;
+
+typedef struct {
+  int pulse_gpio_num;
+  int ctrl_gpio_num;
+  pcnt_ctrl_mode_t lctrl_mode;
+  pcnt_ctrl_mode_t hctrl_mode;
+  pcnt_count_mode_t pos_mode;
+  pcnt_count_mode_t neg_mode;
+  int16_t counter_h_lim;
+  int16_t counter_l_lim;
+  pcnt_unit_t unit;
+  pcnt_channel_t channel;
+} pcnt_config_t;
+
+inline esp_err_t pcnt_unit_config(const pcnt_config_t*) { return ESP_OK; }
+inline esp_err_t pcnt_filter_disable(pcnt_unit_t) { return ESP_OK; }
+inline esp_err_t pcnt_counter_pause(pcnt_unit_t) { return ESP_OK; }
+inline esp_err_t pcnt_counter_clear(pcnt_unit_t) { return ESP_OK; }
+inline esp_err_t pcnt_counter_resume(pcnt_unit_t) { return ESP_OK; }
+inline esp_err_t pcnt_get_counter_value(pcnt_unit_t, int16_t* count) { *count = 0; return ESP_OK; }